@@ -125,12 +125,12 @@ namespace CANLib
 	{
 		if (can_frame.data[0] == 0)
 		{
-			Matrix::matrixObj.HideLayer(2);
+			Matrix::HideLayer(2);
 			Outputs::outObj.SetOff(2);
 		}
 		else
 		{
-			Matrix::matrixObj.ShowLayer(2);
+			Matrix::ShowLayer(2);
 			Outputs::outObj.SetOn(2);
 		}
 		obj_side_beam.SetValue(0, on_off_validator(can_frame.data[0]), CAN_TIMER_TYPE_NONE, CAN_EVENT_TYPE_NORMAL);
@@ -143,12 +143,12 @@ namespace CANLib
 	{
 		if (can_frame.data[0] == 0)
 		{
-			Matrix::matrixObj.HideLayer(4);
+			Matrix::HideLayer(4);
 			Outputs::outObj.SetOff(4);
 		}
 		else
 		{
-			Matrix::matrixObj.ShowLayer(4);
+			Matrix::ShowLayer(4);
 			Outputs::outObj.SetOn(4);
 		}
 		obj_brake_light.SetValue(0, on_off_validator(can_frame.data[0]), CAN_TIMER_TYPE_NONE, CAN_EVENT_TYPE_NORMAL);
@@ -161,12 +161,12 @@ namespace CANLib
 	{
 		if (can_frame.data[0] == 0)
 		{
-			Matrix::matrixObj.HideLayer(3);
+			Matrix::HideLayer(3);
 			Outputs::outObj.SetOff(3);
 		}
 		else
 		{
-			Matrix::matrixObj.ShowLayer(3);
+			Matrix::ShowLayer(3);
 			Outputs::outObj.SetOn(3);
 		}
 		obj_reverse_light.SetValue(0, on_off_validator(can_frame.data[0]), CAN_TIMER_TYPE_NONE, CAN_EVENT_TYPE_NORMAL);
@@ -179,12 +179,12 @@ namespace CANLib
 	{
 		if (can_frame.data[0] == 0)
 		{
-			Matrix::matrixObj.HideLayer(5);
+			Matrix::HideLayer(5);
 			Outputs::outObj.SetOff(5);
 		}
 		else
 		{
-			Matrix::matrixObj.ShowLayer(5);
+			Matrix::ShowLayer(5);
 			Outputs::outObj.SetOn(5, CFG_TurnTimeOn, CFG_TurnTimeOf);
 		}
 		obj_left_indicator.SetValue(0, on_off_validator(can_frame.data[0]), CAN_TIMER_TYPE_NONE, CAN_EVENT_TYPE_NORMAL);
@@ -197,12 +197,12 @@ namespace CANLib
 	{
 		if (can_frame.data[0] == 0)
 		{
-			Matrix::matrixObj.HideLayer(6);
+			Matrix::HideLayer(6);
 			Outputs::outObj.SetOff(6);
 		}
 		else
 		{
-			Matrix::matrixObj.ShowLayer(6);
+			Matrix::ShowLayer(6);
 			Outputs::outObj.SetOn(6, CFG_TurnTimeOn, CFG_TurnTimeOf);
 		}
 		obj_right_indicator.SetValue(0, on_off_validator(can_frame.data[0]), CAN_TIMER_TYPE_NONE, CAN_EVENT_TYPE_NORMAL);
@@ -215,13 +215,13 @@ namespace CANLib
 	{
 		if (can_frame.data[0] == 0)
 		{
-			Matrix::matrixObj.HideLayer(7);
+			Matrix::HideLayer(7);
 			Outputs::outObj.SetOff(5);
 			Outputs::outObj.SetOff(6);
 		}
 		else
 		{
-			Matrix::matrixObj.ShowLayer(7);
+			Matrix::ShowLayer(7);
 			Outputs::outObj.SetOn(5, CFG_TurnTimeOn, CFG_TurnTimeOf);
 			Outputs::outObj.SetOn(6, CFG_TurnTimeOn, CFG_TurnTimeOf);
 		}
@@ -251,17 +251,16 @@ namespace CANLib
 	{
 		if (can_frame.data[0] == 0)
 		{
-			//Matrix::matrixObj.HideLayer(1);
-			Matrix::matrixObj.RegLayer("layer1.pxl", 1);
-			Matrix::matrixObj.ShowLayer(1);
+			//Matrix::HideLayer(1);
+			Matrix::SwapImage(Pxl::PACK_LAYER + 1, "layer1.pxl", 1, Matrix::CFG_FadeFrames);
 		}
 		else
 		{
 			char filename[13];
 			sprintf(filename, "user%03d.pxl", can_frame.data[0]);
-			Matrix::matrixObj.RegLayer(filename, 1);
-			Matrix::matrixObj.ShowLayer(1);
+			Matrix::SwapImage(Pxl::PACK_USER + can_frame.data[0] - 1, filename, 1, Matrix::CFG_FadeFrames);
 		}
+		Logger.PrintTopic("PXL").Printf("Image %d: %d ms, sector cache: %d hits, %d misses", can_frame.data[0], Matrix::image_reg_time, (int)Matrix::sector_cache[0], (int)Matrix::sector_cache[1]).PrintNewLine();
 		obj_custom_image.SetValue(0, on_off_validator(can_frame.data[0]), CAN_TIMER_TYPE_NONE, CAN_EVENT_TYPE_NORMAL);
 
 		return CAN_RESULT_IGNORE;
@@ -303,6 +302,21 @@ namespace CANLib
 		// Set versions data to block_info.
 		obj_block_info.SetValue(0, (About::board_type << 3 | About::board_ver), CAN_TIMER_TYPE_NORMAL);
 		obj_block_info.SetValue(1, (About::soft_ver << 2 | About::can_ver), CAN_TIMER_TYPE_NORMAL);
+
+		// Профиль SD-карты из замеров при старте: { init[0] latency[1..2] single[3] multi[4] spi[5] ahead[6] },
+		// время инициализации в 10 мс, задержка в мкс, скорости чтения в 8 КБ/с, упреждающее чтение 0/1.
+		// Если замеры не удались, объект не заполняется.
+		DISK_BENCHMARK bench = {};
+		if(disk_ioctl(0, CTRL_PROFILE, &bench) == RES_OK)
+		{
+			obj_block_health.SetValue(0, (bench.init_time / 10 > 255) ? 255 : bench.init_time / 10, CAN_TIMER_TYPE_NORMAL);
+			obj_block_health.SetValue(1, bench.latency & 0xFF, CAN_TIMER_TYPE_NORMAL);
+			obj_block_health.SetValue(2, bench.latency >> 8, CAN_TIMER_TYPE_NORMAL);
+			obj_block_health.SetValue(3, (bench.single_rate / 8 > 255) ? 255 : bench.single_rate / 8, CAN_TIMER_TYPE_NORMAL);
+			obj_block_health.SetValue(4, (bench.multi_rate / 8 > 255) ? 255 : bench.multi_rate / 8, CAN_TIMER_TYPE_NORMAL);
+			obj_block_health.SetValue(5, bench.spi_divider, CAN_TIMER_TYPE_NORMAL);
+			obj_block_health.SetValue(6, (bench.read_ahead > 0) ? 1 : 0, CAN_TIMER_TYPE_NORMAL);
+		}
 		
 		return;
 	}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <PxlFormat.h>
+
+/*
+	Рисование поверх готового кадра MatrixLed<>.
+	Работает прямо в буфере кадра: 3 байта на пиксель в порядке GRB, вертикальный зигзаг.
+	Яркость применяется так же, как к слоям матрицы, чтобы наложение не выделялось.
+*/
+template <uint8_t _width, uint8_t _height>
+class MatrixCanvas
+{
+	public:
+
+		void Attach(uint8_t *buffer, uint16_t length)
+		{
+			_buffer = (length >= (uint16_t)_width * _height * 3) ? buffer : nullptr;
+
+			return;
+		}
+
+		void SetBrightness(uint8_t brightness)
+		{
+			_brightness = brightness + 1;
+
+			return;
+		}
+
+		bool IsReady() const
+		{
+			return (_buffer != nullptr);
+		}
+
+		void BlendPixel(uint8_t x, uint8_t y, const Pxl::rgba_t &color)
+		{
+			if(color.a == 0) return;
+
+			uint8_t *dst = _buffer + _Offset(x, y);
+			if(color.a == 0xFF)
+			{
+				dst[0] = _Scale(color.g);
+				dst[1] = _Scale(color.r);
+				dst[2] = _Scale(color.b);
+			}
+			else
+			{
+				dst[0] = _Mix(dst[0], _Scale(color.g), color.a);
+				dst[1] = _Mix(dst[1], _Scale(color.r), color.a);
+				dst[2] = _Mix(dst[2], _Scale(color.b), color.a);
+			}
+
+			return;
+		}
+
+		// Строка из count пикселей начиная с (x, y), обрезается по краям панели.
+		// opacity (0..256) дополнительно ослабляет прозрачность всех пикселей строки.
+		void BlendRow(int16_t x, int16_t y, const Pxl::rgba_t *pixels, uint8_t count, uint16_t opacity = 256)
+		{
+			if(_buffer == nullptr || y < 0 || y >= _height) return;
+
+			int16_t from = (x < 0) ? -x : 0;
+			int16_t to = (x + count > _width) ? (_width - x) : count;
+			for(int16_t i = from; i < to; ++i)
+			{
+				if(opacity < 256)
+				{
+					Pxl::rgba_t color = pixels[i];
+					color.a = (color.a * opacity) >> 8;
+					BlendPixel(x + i, y, color);
+				}
+				else
+				{
+					BlendPixel(x + i, y, pixels[i]);
+				}
+			}
+
+			return;
+		}
+
+		// Серия из count пикселей одного цвета начиная с (x, y), обрезается по краям панели.
+		void FillRun(int16_t x, int16_t y, Pxl::rgba_t color, uint8_t count, uint16_t opacity = 256)
+		{
+			if(_buffer == nullptr || y < 0 || y >= _height) return;
+
+			if(opacity < 256) color.a = (color.a * opacity) >> 8;
+			if(color.a == 0) return;
+
+			int16_t from = (x < 0) ? 0 : x;
+			int16_t to = (x + count > _width) ? _width : (x + count);
+			for(int16_t i = from; i < to; ++i)
+			{
+				BlendPixel(i, y, color);
+			}
+
+			return;
+		}
+
+	private:
+
+		static uint16_t _Offset(uint8_t x, uint8_t y)
+		{
+			uint16_t idx = (uint16_t)x * _height + ((x & 0x01) ? (_height - 1 - y) : y);
+
+			return idx * 3;
+		}
+
+		uint8_t _Scale(uint8_t value) const
+		{
+			return (value * _brightness) >> 8;
+		}
+
+		static uint8_t _Mix(uint8_t dst, uint8_t src, uint8_t alpha)
+		{
+			return (src * alpha + dst * (255 - alpha) + 127) / 255;
+		}
+
+		uint8_t *_buffer = nullptr;
+		uint16_t _brightness = 256;
+};
@@ -0,0 +1,1388 @@
+#pragma once
+
+#include <string.h>
+#include <PxlFormat.h>
+#include <PxlFile.h>
+
+/*
+	Проигрыватель слоёв в формате PXL2.
+	Слои выводятся поверх кадра MatrixLed<> по возрастанию id, кадр читается с SD-карты построчно.
+	Слой может быть меньше панели: он выводится в своём прямоугольнике (x, y из заголовка),
+	выходящая за панель часть обрезается.
+	При включённой интерполяции между соседними кадрами выводится промежуточный кадр,
+	смешанный в фиксированной точке по времени, прошедшему с начала кадра.
+	Кадры RLE смешиваются с экраном сериями прямо при чтении, без распаковки в буфер;
+	прозрачные серии просто пропускаются. Интерполяция для них, как и для дельта-кадров, не выполняется.
+	Слою с дельта-кадрами нужен буфер кадра из общей памяти _arenaSize: изменения
+	накладываются на него на месте, с карты читаются только изменившиеся участки.
+	Палитра слоя с индексными кадрами тоже хранится в этой памяти, строка индексов
+	раскрывается в цвета на месте в буфере строки. Память выделяется только видимым слоям:
+	при показе слоя и освобождается при скрытии. Если её не хватает, слой с большим id
+	забирает буфер у видимых слоёв с меньшим id, они ждут, пока память освободится.
+	Если в файле есть таблица кадров, запись нужного кадра читается при переходе на него:
+	смещение кадра RLE и его длительность известны сразу, без чтения предыдущих кадров.
+	Для каждого файла строится таблица кластеров в общей памяти _linkMapSize, размером по
+	числу фрагментов файла, поэтому переходы по кадрам не читают FAT. Непрерывному файлу
+	таблица не нужна: он читается прямо по секторам.
+	В свободное от вывода время Prefetch() заранее читает данные текущего и следующего кадра
+	видимых слоёв в свободную часть _arenaSize, начиная со слоя с ближайшим сроком смены кадра.
+	Вывод берёт данные оттуда, а с карты читает только то, чего в буфере нет. Непрерывные файлы
+	читаются асинхронно: пока карта готовит данные, Prefetch() возвращает управление.
+	Небольшие повторяющиеся анимации при показе целиком загружаются в кэш в конце _arenaSize и дальше
+	проигрываются без обращений к карте. Если места нет, вытесняются давно показанные скрытые слои.
+	Память _arenaSize одна на всё: снизу буферы и палитры, сверху кэш, между ними упреждающее чтение.
+	Буферам она нужна, чтобы слой вообще выводился, поэтому при нехватке они вытесняют кэш, сначала
+	скрытых слоёв, а упреждающему чтению достаётся то, что осталось.
+*/
+template <uint8_t _maxLayers, uint8_t _width, uint8_t _height, uint16_t _arenaSize, uint16_t _linkMapSize>
+class MatrixLayers
+{
+	public:
+
+		// Возвращает false, если файл не в формате PXL2 или не подходит под панель.
+		bool RegLayer(const char *filename, uint8_t id)
+		{
+			if(id >= _maxLayers) return false;
+
+			layer_t &layer = _layers[id];
+			UnregLayer(id);
+
+			if(layer.file.Open(filename) == false) return false;
+
+			return _Register(layer);
+		}
+
+		// Слой из открытого файла, например найденного по индексу папки.
+		bool RegLayer(const PxlFile &file, uint8_t id)
+		{
+			if(id >= _maxLayers) return false;
+
+			layer_t &layer = _layers[id];
+			UnregLayer(id);
+
+			layer.file = file;
+
+			return _Register(layer);
+		}
+
+		// Слой из части открытого файла, например из пакета изображений.
+		bool RegLayer(const PxlFile &source, uint32_t offset, uint32_t length, uint8_t id)
+		{
+			if(id >= _maxLayers) return false;
+
+			layer_t &layer = _layers[id];
+			UnregLayer(id);
+
+			if(layer.file.Open(source, offset, length) == false) return false;
+
+			return _Register(layer);
+		}
+
+		void UnregLayer(uint8_t id)
+		{
+			if(id >= _maxLayers) return;
+
+			_Unregister(_layers[id]);
+
+			return;
+		}
+
+		bool IsRegistered(uint8_t id) const
+		{
+			return (id < _maxLayers && _layers[id].registered == true);
+		}
+
+		// Занято таблицами кластеров, байт.
+		uint16_t LinkMapUsed() const
+		{
+			return _linkMapUsed * sizeof(DWORD);
+		}
+
+		// Кол-во слоёв, таблица которых не поместилась и которые читаются по цепочке FAT.
+		uint8_t LinkMapFallbacks() const
+		{
+			uint8_t count = 0;
+			for(const layer_t &layer : _layers)
+			{
+				if(layer.registered == true && layer.map_size == 0 && layer.file.IsContiguous() == false && layer.file.IsPart() == false && layer.file.IsMemory() == false) ++count;
+			}
+
+			return count;
+		}
+
+		// Кол-во слоёв из непрерывных файлов, читаемых напрямую по секторам.
+		uint8_t ContiguousLayers() const
+		{
+			uint8_t count = 0;
+			for(const layer_t &layer : _layers)
+			{
+				if(layer.registered == true && layer.file.IsContiguous() == true) ++count;
+			}
+
+			return count;
+		}
+
+		void ShowLayer(uint8_t id)
+		{
+			if(IsRegistered(id) == false) return;
+
+			layer_t &layer = _layers[id];
+			layer.visible = true;
+			layer.started = false;
+			_DropFetch(layer);
+			_AllocBuffer(layer, true);
+			_AllocCache(layer);
+
+			return;
+		}
+
+		void HideLayer(uint8_t id)
+		{
+			if(IsRegistered(id) == false) return;
+			if(IsTransition() == true && id == _fadeId) StopTransition();
+
+			layer_t &layer = _layers[id];
+			layer.visible = false;
+			_DropFetch(layer);
+			_FreeBuffer(layer);
+			_ResumeLayers();
+
+			return;
+		}
+
+		// Перейти на кадр frame, дельта-кадры восстанавливаются от ближайшего ключевого.
+		void SeekLayer(uint8_t id, uint16_t frame, uint32_t time)
+		{
+			if(IsRegistered(id) == false || _HasBuffer(_layers[id]) == false) return;
+
+			layer_t &layer = _layers[id];
+			_DropFetch(layer);
+			layer.frame_time = time;
+			layer.started = _SeekFrame(layer, frame % layer.header.frames, true);
+
+			return;
+		}
+
+		// Включить или выключить интерполяцию независимо от флага в файле. Кадры RLE и дельта-кадры не смешиваются.
+		// Промежуточные кадры выводятся при Render(), раз в CFG_Delay: частота вывода от интерполяции не растёт.
+		void SetTween(uint8_t id, bool enable)
+		{
+			if(IsRegistered(id) == false) return;
+
+			_layers[id].tween = (enable == true && _CanTween(_layers[id].header) == true);
+
+			return;
+		}
+
+		/*
+			Плавная смена источника слоя id за frames кадров, вызывается перед регистрацией нового источника.
+			Текущий источник слоя уходит в отдельное место (_fadeSlot) вместе со своей памятью и, пока идёт
+			переход, выводится на месте слоя с весом 1 - k/N, а новый поверх него - с весом k/N. Остальные
+			слои проигрываются как обычно, поэтому переход не задерживает ни сигналы, ни спрайты.
+			Если новому слою не хватает памяти, уходящий источник отдаёт её первым и больше не выводится.
+		*/
+		void StartTransition(uint8_t id, uint8_t frames)
+		{
+			StopTransition();
+			if(id >= _maxLayers || frames < 2) return;
+
+			layer_t &layer = _layers[id];
+			if(layer.registered == true && layer.visible == true)
+			{
+				_layers[_fadeSlot] = layer;
+				layer = layer_t();
+			}
+			_fadeId = id;
+			_fadeFrames = frames;
+			_fadeStep = 0;
+
+			return;
+		}
+
+		void StopTransition()
+		{
+			_fadeFrames = 0;
+			_Unregister(_layers[_fadeSlot]);
+
+			return;
+		}
+
+		bool IsTransition() const
+		{
+			return (_fadeFrames > 0);
+		}
+
+		/*
+			Прочитать с карты данные одного кадра. Вызывается, когда выводить нечего.
+			Выбирается видимый слой с самым ранним сроком: сначала текущий кадр, если его нет в буфере,
+			затем следующий. Если места нет, вытесняется следующий кадр слоя с более поздним сроком.
+			Пока идёт асинхронное чтение кадра, вызов только продвигает его.
+		*/
+		void Prefetch()
+		{
+			if(_load.active == true)
+			{
+				int8_t result = PxlFile::ReadPoll(_load);
+				if(result > 0) return;
+
+				_LoadDone(result == 0);
+			}
+
+			layer_t *best = nullptr;
+			uint8_t best_slot = 0;
+			uint16_t best_frame = 0;
+			uint32_t best_deadline = 0;
+			for(layer_t &layer : _layers)
+			{
+				if(layer.visible == false || layer.started == false || layer.prefetch == false || layer.fetch_blocked == true || layer.cache_size > 0) continue;
+
+				uint8_t slot;
+				uint16_t frame = layer.frame;
+				uint32_t deadline;
+				if(layer.fetch[0].valid == false && layer.header.encoding != Pxl::ENCODING_DELTA)
+				{
+					slot = 0;
+					deadline = layer.frame_time;
+				}
+				else if(layer.fetch[1].valid == false)
+				{
+					int8_t direction = layer.direction;
+					if(_NextFrame(layer.header, frame, direction) == false || frame == layer.frame) continue;
+					slot = 1;
+					deadline = layer.frame_time + layer.frame_delay;
+				}
+				else continue;
+
+				if(best == nullptr || (int32_t)(deadline - best_deadline) < 0)
+				{
+					best = &layer;
+					best_slot = slot;
+					best_frame = frame;
+					best_deadline = deadline;
+				}
+			}
+			if(best == nullptr) return;
+
+			// Неудачная попытка не повторяется до смены кадра слоя.
+			uint32_t offset;
+			uint32_t length;
+			uint16_t pos;
+			if(_FrameRange(*best, best_frame, offset, length) == false || length > _arenaSize || _FetchAlloc(length, best_deadline, pos) == false)
+			{
+				best->fetch_blocked = true;
+				return;
+			}
+
+			fetch_t &fetch = best->fetch[best_slot];
+			fetch.offset = offset;
+			fetch.deadline = best_deadline;
+			fetch.pos = pos;
+			fetch.length = length;
+			fetch.frame = best_frame;
+			fetch.valid = false;
+			fetch.loading = false;
+
+			if(best->file.ReadStart(_load, offset, &_arena[pos], length) == true)
+			{
+				fetch.loading = true;
+				_loadPos = pos;
+				_loadEnd = pos + length;
+				int8_t result = PxlFile::ReadPoll(_load);
+				if(result <= 0) _LoadDone(result == 0);
+			}
+			else if(best->file.Read(offset, &_arena[pos], length) == true)
+			{
+				fetch.valid = true;
+			}
+			else
+			{
+				best->fetch_blocked = true;
+			}
+
+			return;
+		}
+
+		// Смены кадра, данные которых уже были в буфере упреждающего чтения.
+		uint32_t PrefetchHits() const
+		{
+			return _fetchHits;
+		}
+
+		// Смены кадра, данные которых пришлось читать с карты во время вывода.
+		uint32_t PrefetchMisses() const
+		{
+			return _fetchMisses;
+		}
+
+		// Чтения данных слоёв, выполненные из кэша.
+		uint32_t CacheHits() const
+		{
+			return _cacheHits;
+		}
+
+		// Чтения данных слоёв с карты.
+		uint32_t CacheMisses() const
+		{
+			return _cacheMisses;
+		}
+
+		// Занято в кэше, байт.
+		uint16_t CacheUsed() const
+		{
+			return _cacheUsed;
+		}
+
+		template <class canvas_t>
+		void Render(canvas_t &canvas, uint32_t time)
+		{
+			// Вес нового источника слоя _fadeId на этом кадре перехода: 1/N .. N/N.
+			uint16_t fade = (IsTransition() == true) ? (256 * (_fadeStep + 1) / _fadeFrames) : 256;
+
+			for(uint8_t id = 0; id < _maxLayers; ++id)
+			{
+				if(IsTransition() == true && id == _fadeId)
+				{
+					if(fade < 256) _RenderVisible(_layers[_fadeSlot], canvas, time, 256 - fade);
+					_RenderVisible(_layers[id], canvas, time, fade);
+					continue;
+				}
+				_RenderVisible(_layers[id], canvas, time, 256);
+			}
+
+			if(IsTransition() == true && ++_fadeStep >= _fadeFrames)
+			{
+				StopTransition();
+			}
+
+			return;
+		}
+
+	private:
+
+		// Данные кадра в буфере упреждающего чтения: байты offset .. offset + length файла слоя.
+		struct fetch_t
+		{
+			uint32_t offset;
+			uint32_t deadline;			// Срок, к которому кадр понадобится.
+			uint16_t pos;				// Смещение в _arena.
+			uint16_t length;
+			uint16_t frame;
+			bool valid;
+			bool loading;				// Идёт асинхронное чтение _load.
+		};
+
+		struct layer_t
+		{
+			PxlFile file;
+			Pxl::layer_header_t header;
+			uint32_t frame_time;		// Время начала текущего кадра.
+			uint32_t frame_offset;		// Смещение текущего кадра RLE или дельта-кадра в файле.
+			uint16_t frame_size;		// Размер его данных без префикса размера.
+			uint16_t frame_delay;		// Длительность текущего кадра, мс.
+			uint16_t frame;
+			int8_t direction;			// PLAY_PINGPONG: 1 - вперёд, -1 - назад.
+			uint16_t buffer_offset;		// Буфер кадра или палитра в _arena.
+			uint16_t buffer_size;		// 0 - буфер не выделен.
+			uint16_t map_offset;		// Таблица кластеров в _linkMap.
+			uint16_t map_size;			// 0 - таблицы нет.
+			fetch_t fetch[2];			// Текущий и следующий кадр.
+			uint16_t cache_offset;		// Файл целиком в кэше в _arena.
+			uint16_t cache_size;		// 0 - файл не в кэше.
+			uint16_t cache_used;		// Номер последнего показа, для вытеснения.
+			bool prefetch;				// Кадр помещается в буфер упреждающего чтения.
+			bool fetch_blocked;			// Чтение следующего кадра не удалось, до смены кадра не повторять.
+			bool registered;
+			bool visible;
+			bool started;
+			bool tween;
+		};
+
+		// Последовательное чтение данных кадра кусками прямо из памяти, где они лежат (_Map()).
+		// В буфер строк копируется только запись, разрезанная границей куска.
+		struct stream_t
+		{
+			uint32_t pos;				// Следующий непрочитанный байт в файле.
+			uint32_t end;
+			const uint8_t *data;		// Текущий кусок.
+			uint16_t length;			// Байт в куске.
+			uint16_t idx;				// Текущий байт в куске.
+		};
+
+		void _Unregister(layer_t &layer)
+		{
+			layer.file.Close();
+			_FreeBuffer(layer);
+			_FreeLinkMap(layer);
+			_FreeCache(layer);
+			_DropFetch(layer);
+			layer.registered = false;
+			layer.visible = false;
+			_ResumeLayers();
+
+			return;
+		}
+
+		bool _Register(layer_t &layer)
+		{
+			layer.buffer_size = 0;
+			if(_ReadHeader(layer) == false || _BufferSize(layer.header) > _arenaSize)
+			{
+				layer.file.Close();
+				return false;
+			}
+			_AllocLinkMap(layer);
+			_DropFetch(layer);
+			layer.tween = ((layer.header.flags & Pxl::LAYER_FLAG_TWEEN) && _CanTween(layer.header) == true);
+			switch(layer.header.encoding)
+			{
+				case Pxl::ENCODING_RLE:
+				case Pxl::ENCODING_DELTA: { layer.prefetch = (layer.file.IsMemory() == false); break; }
+				// Текущий и следующий кадр должны помещаться в половину общей памяти, вторая - буферам и кэшу.
+				default: { layer.prefetch = (layer.file.IsMemory() == false && (uint32_t)layer.header.height * _RowBytes(layer.header) <= _arenaSize / 4); break; }
+			}
+			layer.registered = true;
+
+			return true;
+		}
+
+		bool _ReadHeader(layer_t &layer)
+		{
+			Pxl::layer_header_t &header = layer.header;
+			memset(&header, 0x00, sizeof(header));
+
+			// Сначала общая часть, по ней узнаём фактический размер заголовка.
+			if(layer.file.Read(0, &header, 8) == false) return false;
+			if(memcmp(header.magic, Pxl::LAYER_MAGIC, sizeof(header.magic)) != 0 || header.version != Pxl::LAYER_VERSION) return false;
+			if(header.header_size < 8) return false;
+
+			uint16_t length = (header.header_size < sizeof(header)) ? header.header_size : sizeof(header);
+			if(layer.file.Read(0, &header, length) == false) return false;
+
+			if(header.width == 0 || header.width > _width || header.height == 0 || header.height > _height) return false;
+			if(header.frames == 0) return false;
+
+			if(header.loop_end == 0 || header.loop_end >= header.frames) header.loop_end = header.frames - 1;
+			if(header.loop_start > header.loop_end) header.loop_start = 0;
+
+			switch(header.encoding)
+			{
+				case Pxl::ENCODING_RGBA:
+				case Pxl::ENCODING_RLE:
+				{
+					break;
+				}
+				case Pxl::ENCODING_DELTA:
+				{
+					if(header.key_interval == 0) header.key_interval = header.frames;
+					break;
+				}
+				case Pxl::ENCODING_PAL4:
+				case Pxl::ENCODING_PAL8:
+				{
+					uint16_t max = (header.encoding == Pxl::ENCODING_PAL4) ? 16 : Pxl::PALETTE_MAX;
+					if(header.palette_count == 0 || header.palette_count > max) return false;
+					break;
+				}
+				default:
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		static bool _CanTween(const Pxl::layer_header_t &header)
+		{
+			return (header.encoding != Pxl::ENCODING_RLE && header.encoding != Pxl::ENCODING_DELTA);
+		}
+
+		// Размер буфера кадра или палитры, 0 - слою буфер не нужен.
+		static uint32_t _BufferSize(const Pxl::layer_header_t &header)
+		{
+			switch(header.encoding)
+			{
+				case Pxl::ENCODING_DELTA: { return (uint32_t)header.width * header.height * sizeof(Pxl::rgba_t); }
+				case Pxl::ENCODING_PAL4:
+				case Pxl::ENCODING_PAL8: { return header.palette_count * sizeof(Pxl::rgba_t); }
+				default: { return 0; }
+			}
+		}
+
+		bool _HasBuffer(const layer_t &layer) const
+		{
+			return (layer.buffer_size > 0 || _BufferSize(layer.header) == 0);
+		}
+
+		// preempt - забрать память у видимых слоёв с меньшим id, начиная с нижнего. Они остаются
+		// видимыми, но не выводятся, пока _ResumeLayers() не выделит им память снова.
+		bool _AllocBuffer(layer_t &layer, bool preempt)
+		{
+			const Pxl::layer_header_t &header = layer.header;
+			uint32_t size = _BufferSize(header);
+			if(_HasBuffer(layer) == true) return true;
+
+			while(size > _ArenaFree())
+			{
+				// Сначала кэш, скрытых слоёв, затем видимых: без него слой всё равно выводится.
+				if(_EvictCache(false) == true || _EvictCache(true) == true) continue;
+				if(preempt == false) return false;
+
+				// Сначала память уходящего при переходе источника, затем слоёв с меньшим id.
+				layer_t *victim = nullptr;
+				if(_layers[_fadeSlot].buffer_size > 0 && &layer != &_layers[_fadeSlot]) victim = &_layers[_fadeSlot];
+				for(layer_t &other : _layers)
+				{
+					if(victim != nullptr || &other == &layer) break;
+					if(other.buffer_size > 0)
+					{
+						victim = &other;
+						break;
+					}
+				}
+				if(victim == nullptr) return false;
+
+				_FreeBuffer(*victim);
+				_DropFetch(*victim);
+				victim->started = false;
+			}
+
+			// Палитра читается сразу, буфер дельта-кадров заполнит ключевой кадр.
+			_ClaimArena(_bufferUsed, _bufferUsed + size);
+			if(header.palette_count > 0)
+			{
+				if(_Read(layer, header.header_size, &_arena[_bufferUsed], size) == false) return false;
+			}
+
+			layer.buffer_offset = _bufferUsed;
+			layer.buffer_size = size;
+			_bufferUsed += size;
+			layer.started = false;
+
+			return true;
+		}
+
+		// Вернуть память ожидающим видимым слоям, начиная с верхнего.
+		void _ResumeLayers()
+		{
+			for(uint8_t id = _maxLayers; id > 0; --id)
+			{
+				layer_t &layer = _layers[id - 1];
+				if(layer.visible == true && _HasBuffer(layer) == false)
+				{
+					_AllocBuffer(layer, false);
+				}
+			}
+
+			return;
+		}
+
+		void _FreeBuffer(layer_t &layer)
+		{
+			if(layer.buffer_size == 0) return;
+
+			uint16_t tail = layer.buffer_offset + layer.buffer_size;
+			memmove(&_arena[layer.buffer_offset], &_arena[tail], _bufferUsed - tail);
+			for(layer_t &other : _layers)
+			{
+				if(other.buffer_size > 0 && other.buffer_offset > layer.buffer_offset)
+				{
+					other.buffer_offset -= layer.buffer_size;
+				}
+			}
+			_bufferUsed -= layer.buffer_size;
+			layer.buffer_size = 0;
+
+			return;
+		}
+
+		void _AllocLinkMap(layer_t &layer)
+		{
+			layer.map_size = 0;
+
+			// Часть файла пользуется его таблицей, массиву во flash таблица не нужна.
+			if(layer.file.IsPart() == true || layer.file.IsMemory() == true) return;
+
+			// Сначала узнаём размер таблицы, непрерывному файлу она не понадобится.
+			DWORD probe[4];
+			uint32_t need = layer.file.LinkMap(probe, 4);
+			if(layer.file.IsContiguous() == true) return;
+
+			if(need == 0 || need > (uint32_t)(_linkMapSize - _linkMapUsed) || layer.file.LinkMap(&_linkMap[_linkMapUsed], need) != need)
+			{
+				layer.file.LinkMap(nullptr, 0);
+				return;
+			}
+			layer.map_offset = _linkMapUsed;
+			layer.map_size = need;
+			_linkMapUsed += need;
+
+			return;
+		}
+
+		void _FreeLinkMap(layer_t &layer)
+		{
+			if(layer.map_size == 0) return;
+
+			uint16_t tail = layer.map_offset + layer.map_size;
+			memmove(&_linkMap[layer.map_offset], &_linkMap[tail], (_linkMapUsed - tail) * sizeof(DWORD));
+			for(layer_t &other : _layers)
+			{
+				if(other.map_size > 0 && other.map_offset > layer.map_offset)
+				{
+					other.map_offset -= layer.map_size;
+					other.file.MoveLinkMap(&_linkMap[other.map_offset]);
+				}
+			}
+			_linkMapUsed -= layer.map_size;
+			layer.map_size = 0;
+
+			return;
+		}
+
+		Pxl::rgba_t *_Pixels(layer_t &layer)
+		{
+			return (Pxl::rgba_t *)&_arena[layer.buffer_offset];
+		}
+
+		void _Step(layer_t &layer, uint32_t time)
+		{
+			if(layer.started == false)
+			{
+				_DropFetch(layer);
+				layer.frame_time = time;
+				layer.direction = 1;
+				layer.started = _SeekFrame(layer, 0, true);
+				return;
+			}
+
+			uint16_t target = layer.frame;
+			uint16_t delay = layer.frame_delay;
+			for(uint16_t i = 0; delay > 0 && time - layer.frame_time >= delay; ++i)
+			{
+				// После долгой паузы пропущенные кадры не догоняем.
+				if(i >= layer.header.frames)
+				{
+					layer.frame_time = time;
+					break;
+				}
+				if(_NextFrame(layer.header, target, layer.direction) == false) break;
+
+				layer.frame_time += delay;
+				delay = _FrameDelay(layer, target);
+			}
+			if(target == layer.frame) return;
+
+			// Следующий кадр из буфера становится текущим, данные дельта-кадра после наложения не нужны.
+			fetch_t &next = layer.fetch[1];
+			bool ready = (next.valid == true && next.frame == target);
+			if(layer.prefetch == true && layer.cache_size == 0)
+			{
+				if(ready == true) ++_fetchHits;
+				else ++_fetchMisses;
+			}
+			layer.started = _SeekFrame(layer, target, false);
+			layer.fetch[0] = next;
+			layer.fetch[0].valid = (ready == true && layer.header.encoding != Pxl::ENCODING_DELTA);
+			layer.fetch[0].loading = (next.loading == true && next.frame == target && layer.header.encoding != Pxl::ENCODING_DELTA);
+			next.valid = false;
+			next.loading = false;
+			layer.fetch_blocked = false;
+
+			return;
+		}
+
+		// Следующий кадр с учётом режима проигрывания; false - анимация закончилась.
+		static bool _NextFrame(const Pxl::layer_header_t &header, uint16_t &frame, int8_t &direction)
+		{
+			switch(header.mode)
+			{
+				case Pxl::PLAY_ONCE:
+				{
+					if(frame >= header.loop_end) return false;
+					++frame;
+					break;
+				}
+				case Pxl::PLAY_PINGPONG:
+				{
+					if(frame >= header.loop_end)
+					{
+						if(header.loop_start == header.loop_end) return false;
+						direction = -1;
+					}
+					else if(frame <= header.loop_start && direction < 0)
+					{
+						direction = 1;
+					}
+					frame += direction;
+					break;
+				}
+				default:
+				{
+					frame = (frame >= header.loop_end) ? header.loop_start : (frame + 1);
+					break;
+				}
+			}
+
+			return true;
+		}
+
+		bool _FrameEntry(layer_t &layer, uint16_t frame, Pxl::frame_entry_t &entry)
+		{
+			memset(&entry, 0x00, sizeof(entry));
+			if(layer.header.frame_table == 0) return true;
+
+			return _Read(layer, layer.header.frame_table + frame * sizeof(entry), &entry, sizeof(entry));
+		}
+
+		// Длительность кадра, 0 - при ошибке чтения, анимация останавливается.
+		uint16_t _FrameDelay(layer_t &layer, uint16_t frame)
+		{
+			Pxl::frame_entry_t entry;
+			if(_FrameEntry(layer, frame, entry) == false) return 0;
+
+			return (entry.duration > 0) ? entry.duration : layer.header.delay;
+		}
+
+		// Кадры RLE и дельта-кадры разного размера, поэтому без таблицы кадров к целевому кадру идём подряд:
+		// RLE - от текущего или от начала, дельта-кадры - от текущего или от ближайшего ключевого.
+		bool _SeekFrame(layer_t &layer, uint16_t target, bool restart)
+		{
+			const Pxl::layer_header_t &header = layer.header;
+
+			Pxl::frame_entry_t entry;
+			if(_FrameEntry(layer, target, entry) == false) return false;
+			layer.frame_delay = (entry.duration > 0) ? entry.duration : header.delay;
+
+			switch(header.encoding)
+			{
+				case Pxl::ENCODING_RLE:
+				{
+					if(entry.offset > 0) return _LoadFrame(layer, target, entry.offset);
+					if(restart == true || target < layer.frame)
+					{
+						if(_LoadFrame(layer, 0, header.header_size) == false) return false;
+					}
+					break;
+				}
+				case Pxl::ENCODING_DELTA:
+				{
+					uint16_t key = target / header.key_interval;
+					if(restart == true || target < layer.frame || key != layer.frame / header.key_interval)
+					{
+						uint32_t offset;
+						if(_Read(layer, header.key_table + key * sizeof(offset), &offset, sizeof(offset)) == false) return false;
+						if(_LoadFrame(layer, key * header.key_interval, offset) == false) return false;
+					}
+					break;
+				}
+				default:
+				{
+					layer.frame = target;
+					return true;
+				}
+			}
+
+			while(layer.frame < target)
+			{
+				if(_LoadFrame(layer, layer.frame + 1, layer.frame_offset + sizeof(uint16_t) + layer.frame_size) == false) return false;
+			}
+
+			return true;
+		}
+
+		bool _LoadFrame(layer_t &layer, uint16_t frame, uint32_t offset)
+		{
+			layer.frame = frame;
+			layer.frame_offset = offset;
+			if(_Read(layer, offset, &layer.frame_size, sizeof(layer.frame_size)) == false) return false;
+
+			if(layer.header.encoding == Pxl::ENCODING_DELTA)
+			{
+				return _ApplyDelta(layer);
+			}
+
+			return true;
+		}
+
+		// Наложить текущий дельта-кадр на буфер слоя.
+		bool _ApplyDelta(layer_t &layer)
+		{
+			Pxl::rgba_t *pixels = _Pixels(layer);
+			uint8_t width = layer.header.width;
+
+			stream_t stream;
+			_StreamBegin(layer, stream);
+			if(_StreamFill(layer, stream, 1) == false) return false;
+
+			if(stream.data[stream.idx++] == Pxl::DELTA_KEYFRAME)
+			{
+				return _ReadRle(layer, stream, [&](uint16_t x, uint8_t y, uint8_t run, const Pxl::rgba_t *color)
+				{
+					Pxl::rgba_t *dst = &pixels[y * width + x];
+					for(uint8_t i = 0; i < run; ++i)
+					{
+						if(color != nullptr) dst[i] = *color;
+						else memset(&dst[i], 0x00, sizeof(dst[i]));
+					}
+				});
+			}
+
+			while(stream.idx < stream.length || stream.pos < stream.end)
+			{
+				if(_StreamFill(layer, stream, 3) == false) return false;
+
+				uint8_t x = stream.data[stream.idx];
+				uint8_t y = stream.data[stream.idx + 1];
+				uint8_t count = stream.data[stream.idx + 2];
+				stream.idx += 3;
+				if(x + count > width || y >= layer.header.height) return false;
+
+				uint16_t length = count * sizeof(Pxl::rgba_t);
+				if(_StreamFill(layer, stream, length) == false) return false;
+				memcpy(&pixels[y * width + x], &stream.data[stream.idx], length);
+				stream.idx += length;
+			}
+
+			return true;
+		}
+
+		template <class canvas_t>
+		void _RenderVisible(layer_t &layer, canvas_t &canvas, uint32_t time, uint16_t opacity)
+		{
+			if(layer.visible == false || _HasBuffer(layer) == false) return;
+
+			_Step(layer, time);
+			_RenderLayer(layer, canvas, time, opacity);
+
+			return;
+		}
+
+		template <class canvas_t>
+		void _RenderLayer(layer_t &layer, canvas_t &canvas, uint32_t time, uint16_t opacity = 256)
+		{
+			if(layer.started == false) return;
+
+			const Pxl::layer_header_t &header = layer.header;
+			switch(header.encoding)
+			{
+				case Pxl::ENCODING_RLE:
+				{
+					stream_t stream;
+					_StreamBegin(layer, stream);
+					_ReadRle(layer, stream, [&](uint16_t x, uint8_t y, uint8_t run, const Pxl::rgba_t *color)
+					{
+						if(color != nullptr) canvas.FillRun(header.x + x, header.y + y, *color, run, opacity);
+					});
+					return;
+				}
+				case Pxl::ENCODING_DELTA:
+				{
+					const Pxl::rgba_t *pixels = _Pixels(layer);
+					for(uint8_t y = 0; y < header.height; ++y)
+					{
+						canvas.BlendRow(header.x, header.y + y, &pixels[y * header.width], header.width, opacity);
+					}
+					return;
+				}
+			}
+
+			// Доля следующего кадра, 0..255.
+			uint16_t phase = 0;
+			uint16_t next = layer.frame;
+			int8_t direction = layer.direction;
+			if(layer.tween == true && layer.frame_delay > 0 && _NextFrame(header, next, direction) == true && next != layer.frame)
+			{
+				phase = ((time - layer.frame_time) << 8) / layer.frame_delay;
+				if(phase > 0xFF) phase = 0xFF;
+			}
+
+			for(uint8_t y = 0; y < header.height; ++y)
+			{
+				if(phase == 0 && header.encoding == Pxl::ENCODING_RGBA)
+				{
+					if(_BlendMapped(layer, canvas, y, opacity) == false) return;
+					continue;
+				}
+				if(_ReadRow(layer, layer.frame, y, _row[0]) == false) return;
+				if(phase > 0)
+				{
+					if(_ReadRow(layer, next, y, _row[1]) == false) return;
+					_Lerp(_row[0], _row[1], header.width, phase);
+				}
+				canvas.BlendRow(header.x, header.y + y, _row[0], header.width, opacity);
+			}
+
+			return;
+		}
+
+		// Строка кадра RGBA смешивается с экраном кусками прямо из памяти, где она лежит, без буфера строки.
+		template <class canvas_t>
+		bool _BlendMapped(layer_t &layer, canvas_t &canvas, uint8_t y, uint16_t opacity)
+		{
+			uint8_t width = layer.header.width;
+			uint32_t offset = _RowOffset(layer.header, layer.frame, y);
+			for(uint8_t x = 0; x < width; )
+			{
+				const uint8_t *data;
+				uint32_t length;
+				if(_Map(layer, offset, data, length) == false) return false;
+
+				uint32_t count = length / sizeof(Pxl::rgba_t);
+				if(count > (uint32_t)(width - x)) count = width - x;
+				if(count > 0)
+				{
+					canvas.BlendRow(layer.header.x + x, layer.header.y + y, (const Pxl::rgba_t *)data, count, opacity);
+				}
+				else
+				{
+					// Пиксель разрезан границей сектора.
+					Pxl::rgba_t pixel;
+					if(_Read(layer, offset, &pixel, sizeof(pixel)) == false) return false;
+					canvas.BlendRow(layer.header.x + x, layer.header.y + y, &pixel, 1, opacity);
+					count = 1;
+				}
+				x += count;
+				offset += count * sizeof(Pxl::rgba_t);
+			}
+
+			return true;
+		}
+
+		void _StreamBegin(layer_t &layer, stream_t &stream)
+		{
+			stream.pos = layer.frame_offset + sizeof(uint16_t);
+			stream.end = stream.pos + layer.frame_size;
+			stream.data = nullptr;
+			stream.length = 0;
+			stream.idx = 0;
+
+			return;
+		}
+
+		// Сделать доступными подряд не меньше need байт кадра: следующий кусок, если текущий
+		// прочитан, или остаток текущего с началом следующего в буфере строк.
+		bool _StreamFill(layer_t &layer, stream_t &stream, uint16_t need)
+		{
+			uint16_t rest = stream.length - stream.idx;
+			if(rest >= need) return true;
+			if((uint32_t)(need - rest) > stream.end - stream.pos) return false;
+
+			if(rest == 0)
+			{
+				uint32_t length;
+				if(_Map(layer, stream.pos, stream.data, length) == false) return false;
+				if(length > stream.end - stream.pos) length = stream.end - stream.pos;
+				if(length >= need)
+				{
+					stream.pos += length;
+					stream.length = length;
+					stream.idx = 0;
+					return true;
+				}
+			}
+
+			uint8_t *buffer = (uint8_t *)_row;
+			if(rest > 0) memmove(buffer, &stream.data[stream.idx], rest);
+			if(_Read(layer, stream.pos, &buffer[rest], need - rest) == false) return false;
+			stream.pos += need - rest;
+			stream.data = buffer;
+			stream.length = need;
+			stream.idx = 0;
+
+			return true;
+		}
+
+		// Разбор строк RLE: func(x, y, run, color) для каждой серии, color == nullptr у прозрачной.
+		template <class func_t>
+		bool _ReadRle(layer_t &layer, stream_t &stream, func_t func)
+		{
+			uint16_t x = 0;
+			uint8_t y = 0;
+
+			while(y < layer.header.height)
+			{
+				if(_StreamFill(layer, stream, 1) == false) return false;
+
+				uint8_t ctrl = stream.data[stream.idx++];
+				uint8_t run = (ctrl & ~Pxl::RLE_COLOR) + 1;
+				if(x + run > layer.header.width) return false;
+
+				const Pxl::rgba_t *color = nullptr;
+				if(ctrl & Pxl::RLE_COLOR)
+				{
+					if(_StreamFill(layer, stream, sizeof(Pxl::rgba_t)) == false) return false;
+					color = (const Pxl::rgba_t *)&stream.data[stream.idx];
+					stream.idx += sizeof(Pxl::rgba_t);
+				}
+				func(x, y, run, color);
+
+				x += run;
+				if(x >= layer.header.width)
+				{
+					x = 0;
+					++y;
+				}
+			}
+
+			return true;
+		}
+
+		/*
+			Строка кадра без сжатия. Индексы палитры читаются в конец буфера строки и раскрываются
+			в цвета от начала: пиксель i записывается не дальше байта 4i + 3, а индексы
+			следующих пикселей лежат правее, поэтому второй буфер не нужен.
+		*/
+		bool _ReadRow(layer_t &layer, uint16_t frame, uint8_t y, Pxl::rgba_t *row)
+		{
+			const Pxl::layer_header_t &header = layer.header;
+			uint16_t row_bytes = _RowBytes(header);
+			uint8_t *data = (uint8_t *)row + header.width * sizeof(Pxl::rgba_t) - row_bytes;
+			if(_Read(layer, _RowOffset(header, frame, y), data, row_bytes) == false) return false;
+			if(header.encoding == Pxl::ENCODING_RGBA) return true;
+
+			const Pxl::rgba_t *palette = _Pixels(layer);
+			for(uint8_t x = 0; x < header.width; ++x)
+			{
+				uint8_t idx = (header.encoding == Pxl::ENCODING_PAL8) ? data[x] : ((data[x >> 1] >> ((x & 0x01) ? 0 : 4)) & 0x0F);
+				if(idx < header.palette_count) row[x] = palette[idx];
+				else memset(&row[x], 0x00, sizeof(row[x]));
+			}
+
+			return true;
+		}
+
+		static uint16_t _RowBytes(const Pxl::layer_header_t &header)
+		{
+			switch(header.encoding)
+			{
+				case Pxl::ENCODING_PAL4: { return (header.width + 1) / 2; }
+				case Pxl::ENCODING_PAL8: { return header.width; }
+				default: { return header.width * sizeof(Pxl::rgba_t); }
+			}
+		}
+
+		static uint32_t _RowOffset(const Pxl::layer_header_t &header, uint16_t frame, uint8_t y)
+		{
+			uint32_t data = header.header_size + header.palette_count * sizeof(Pxl::rgba_t);
+
+			return data + ((uint32_t)frame * header.height + y) * _RowBytes(header);
+		}
+
+		// Чтение данных слоя: из кэша или буфера упреждающего чтения, если они там есть, иначе с карты.
+		bool _Read(layer_t &layer, uint32_t offset, void *buffer, uint32_t length)
+		{
+			if(layer.cache_size > 0 && offset + length <= layer.cache_size)
+			{
+				memcpy(buffer, &_arena[layer.cache_offset + offset], length);
+				++_cacheHits;
+				return true;
+			}
+
+			for(const fetch_t &fetch : layer.fetch)
+			{
+				if(fetch.valid == true && offset >= fetch.offset && offset - fetch.offset + length <= fetch.length)
+				{
+					memcpy(buffer, &_arena[fetch.pos + (offset - fetch.offset)], length);
+					return true;
+				}
+			}
+			if(layer.file.IsMemory() == false) ++_cacheMisses;
+
+			return layer.file.Read(offset, buffer, length);
+		}
+
+		// Данные слоя без копирования: указатель в кэш, буфер упреждающего чтения или окно сектора FatFs.
+		bool _Map(layer_t &layer, uint32_t offset, const uint8_t *&data, uint32_t &length)
+		{
+			if(layer.cache_size > 0 && offset < layer.cache_size)
+			{
+				data = &_arena[layer.cache_offset + offset];
+				length = layer.cache_size - offset;
+				++_cacheHits;
+				return true;
+			}
+
+			for(const fetch_t &fetch : layer.fetch)
+			{
+				if(fetch.valid == true && offset >= fetch.offset && offset < fetch.offset + fetch.length)
+				{
+					data = &_arena[fetch.pos + (offset - fetch.offset)];
+					length = fetch.length - (offset - fetch.offset);
+					return true;
+				}
+			}
+			if(layer.file.IsMemory() == false) ++_cacheMisses;
+
+			return layer.file.Map(offset, data, length);
+		}
+
+		/*
+			Байты кадра в файле. Кадр RLE или дельта-кадр - с префиксом размера; следующий за текущим
+			находится по таблице кадров или сразу за текущим, иначе (переход на начало повтора без таблицы) - false.
+			Текущий дельта-кадр уже наложен на буфер слоя и не нужен.
+		*/
+		bool _FrameRange(layer_t &layer, uint16_t frame, uint32_t &offset, uint32_t &length)
+		{
+			const Pxl::layer_header_t &header = layer.header;
+			switch(header.encoding)
+			{
+				case Pxl::ENCODING_RLE:
+				case Pxl::ENCODING_DELTA:
+				{
+					if(frame == layer.frame)
+					{
+						if(header.encoding == Pxl::ENCODING_DELTA) return false;
+						offset = layer.frame_offset;
+						length = sizeof(uint16_t) + layer.frame_size;
+						return true;
+					}
+
+					Pxl::frame_entry_t entry;
+					if(_FrameEntry(layer, frame, entry) == false) return false;
+					if(entry.offset > 0 && header.encoding == Pxl::ENCODING_RLE) offset = entry.offset;
+					else if(frame == layer.frame + 1) offset = layer.frame_offset + sizeof(uint16_t) + layer.frame_size;
+					else return false;
+
+					uint16_t size;
+					if(layer.file.Read(offset, &size, sizeof(size)) == false) return false;
+					length = sizeof(size) + size;
+					return true;
+				}
+				default:
+				{
+					offset = _RowOffset(header, frame, 0);
+					length = (uint32_t)header.height * _RowBytes(header);
+					return true;
+				}
+			}
+		}
+
+		// Место под length байт: первый подходящий промежуток между занятыми записями, при нехватке
+		// вытесняется следующий кадр слоя с самым поздним сроком, если он позже deadline.
+		bool _FetchAlloc(uint16_t length, uint32_t deadline, uint16_t &pos)
+		{
+			for(;;)
+			{
+				if(_FetchFind(length, pos) == true) return true;
+
+				fetch_t *victim = nullptr;
+				for(layer_t &layer : _layers)
+				{
+					fetch_t &fetch = layer.fetch[1];
+					if(fetch.valid == false || (int32_t)(fetch.deadline - deadline) <= 0) continue;
+					if(victim == nullptr || (int32_t)(fetch.deadline - victim->deadline) > 0) victim = &fetch;
+				}
+				if(victim == nullptr) return false;
+
+				victim->valid = false;
+			}
+		}
+
+		// Кандидаты - место сразу за буферами слоёв и конец каждой занятой записи.
+		bool _FetchFind(uint16_t length, uint16_t &pos) const
+		{
+			pos = _bufferUsed;
+			if(_FetchFree(pos, length) == true) return true;
+
+			for(const layer_t &layer : _layers)
+			{
+				for(const fetch_t &fetch : layer.fetch)
+				{
+					if(fetch.valid == false) continue;
+
+					pos = fetch.pos + fetch.length;
+					if(_FetchFree(pos, length) == true) return true;
+				}
+			}
+
+			return false;
+		}
+
+		bool _FetchFree(uint16_t pos, uint16_t length) const
+		{
+			if(pos < _bufferUsed || pos + length > _arenaSize - _cacheUsed) return false;
+			if(_load.active == true && pos < _loadEnd && _loadPos < pos + length) return false;
+
+			for(const layer_t &layer : _layers)
+			{
+				for(const fetch_t &fetch : layer.fetch)
+				{
+					if(fetch.valid == true && pos < fetch.pos + fetch.length && fetch.pos < pos + length) return false;
+				}
+			}
+
+			return true;
+		}
+
+		// Загрузить в кэш файл повторяющейся анимации, если он помещается в кэш целиком.
+		void _AllocCache(layer_t &layer)
+		{
+			layer.cache_used = ++_cacheClock;
+			if(layer.cache_size > 0) return;
+
+			const Pxl::layer_header_t &header = layer.header;
+			uint32_t size = layer.file.Size();
+			if(layer.file.IsMemory() == true || header.mode == Pxl::PLAY_ONCE || header.frames < 2 || size == 0 || size > _arenaSize) return;
+
+			while(size > _ArenaFree())
+			{
+				if(_EvictCache(false) == false) return;
+			}
+
+			// Кэш растёт от конца памяти вниз, навстречу буферам слоёв.
+			uint16_t offset = _arenaSize - _cacheUsed - size;
+			_ClaimArena(offset, offset + size);
+			if(layer.file.Read(0, &_arena[offset], size) == false) return;
+
+			layer.cache_offset = offset;
+			layer.cache_size = size;
+			_cacheUsed += size;
+
+			return;
+		}
+
+		void _FreeCache(layer_t &layer)
+		{
+			if(layer.cache_size == 0) return;
+
+			uint16_t base = _arenaSize - _cacheUsed;
+			memmove(&_arena[base + layer.cache_size], &_arena[base], layer.cache_offset - base);
+			for(layer_t &other : _layers)
+			{
+				if(other.cache_size > 0 && other.cache_offset < layer.cache_offset)
+				{
+					other.cache_offset += layer.cache_size;
+				}
+			}
+			_cacheUsed -= layer.cache_size;
+			layer.cache_size = 0;
+
+			return;
+		}
+
+		// Вытеснить из кэша давно показанный слой, видимый или скрытый; false - таких нет.
+		bool _EvictCache(bool visible)
+		{
+			layer_t *victim = nullptr;
+			for(layer_t &other : _layers)
+			{
+				if(other.cache_size == 0 || other.visible != visible) continue;
+				if(victim == nullptr || (int16_t)(other.cache_used - victim->cache_used) < 0) victim = &other;
+			}
+			if(victim == nullptr) return false;
+
+			_FreeCache(*victim);
+
+			return true;
+		}
+
+		uint16_t _ArenaFree() const
+		{
+			return _arenaSize - _bufferUsed - _cacheUsed;
+		}
+
+		/*
+			Место begin .. end отходит буферу слоя или кэшу: записи упреждающего чтения в нём сбрасываются.
+			Если туда ещё идёт асинхронное чтение, сначала дожидаемся его конца, иначе оно допишет
+			данные поверх палитры или кэша.
+		*/
+		void _ClaimArena(uint16_t begin, uint16_t end)
+		{
+			if(_load.active == true && _loadPos < end && begin < _loadEnd)
+			{
+				int8_t result;
+				do
+				{
+					result = PxlFile::ReadPoll(_load);
+				} while(result > 0);
+				_LoadDone(result == 0);
+			}
+
+			for(layer_t &layer : _layers)
+			{
+				for(fetch_t &fetch : layer.fetch)
+				{
+					if(fetch.pos < end && begin < fetch.pos + fetch.length)
+					{
+						fetch.valid = false;
+						fetch.loading = false;
+					}
+				}
+			}
+
+			return;
+		}
+
+		// Данные, чтение которых ещё идёт, после сброса просто не используются.
+		void _DropFetch(layer_t &layer)
+		{
+			layer.fetch[0].valid = false;
+			layer.fetch[0].loading = false;
+			layer.fetch[1].valid = false;
+			layer.fetch[1].loading = false;
+			layer.fetch_blocked = false;
+
+			return;
+		}
+
+		// Асинхронное чтение закончилось: кадр, для которого оно шло, если он ещё нужен, готов.
+		void _LoadDone(bool success)
+		{
+			for(layer_t &layer : _layers)
+			{
+				for(fetch_t &fetch : layer.fetch)
+				{
+					if(fetch.loading == false) continue;
+
+					fetch.loading = false;
+					fetch.valid = success;
+					if(success == false) layer.fetch_blocked = true;
+				}
+			}
+
+			return;
+		}
+
+		static void _Lerp(Pxl::rgba_t *dst, const Pxl::rgba_t *next, uint8_t count, uint16_t phase)
+		{
+			for(uint8_t i = 0; i < count; ++i)
+			{
+				dst[i].r += ((int16_t)next[i].r - dst[i].r) * phase >> 8;
+				dst[i].g += ((int16_t)next[i].g - dst[i].g) * phase >> 8;
+				dst[i].b += ((int16_t)next[i].b - dst[i].b) * phase >> 8;
+				dst[i].a += ((int16_t)next[i].a - dst[i].a) * phase >> 8;
+			}
+
+			return;
+		}
+
+		// Последнее место - источник слоя, уходящий при плавной смене (StartTransition()).
+		static constexpr uint8_t _fadeSlot = _maxLayers;
+		layer_t _layers[_maxLayers + 1] = {};
+		Pxl::rgba_t _row[2][_width];
+
+		static_assert(sizeof(_row) >= 3 + Pxl::DELTA_MAX_SPAN * sizeof(Pxl::rgba_t), "Row buffer is too small for delta span");
+
+		// Буферы слоёв с начала, кэш с конца, упреждающее чтение - в промежутке.
+		uint8_t _arena[_arenaSize];
+		uint16_t _bufferUsed = 0;
+
+		DWORD _linkMap[_linkMapSize];
+		uint16_t _linkMapUsed = 0;
+
+		PxlFile::async_t _load = {};
+		uint16_t _loadPos = 0;			// Место в _arena, куда идёт чтение _load.
+		uint16_t _loadEnd = 0;
+		uint32_t _fetchHits = 0;
+		uint32_t _fetchMisses = 0;
+
+		uint16_t _cacheUsed = 0;
+		uint16_t _cacheClock = 0;
+		uint32_t _cacheHits = 0;
+		uint32_t _cacheMisses = 0;
+
+		uint8_t _fadeId = 0;
+		uint8_t _fadeFrames = 0;
+		uint8_t _fadeStep = 0;
+};
@@ -2,12 +2,28 @@
 
 //#define MATRIX_STEP_BY_STEP
 #include <MatrixLed.h>
+#include <MatrixCanvas.h>
+#include <MatrixLayers.h>
+#include <MatrixSprites.h>
+#include <PxlPack.h>
+#include <PxlDirIndex.h>
+#include <PxlFlash.h>
 
 extern TIM_HandleTypeDef htim2;
-extern DMA_HandleTypeDef hdma_tim2_ch1;
+extern DMA_HandleTypeDef hdma_tim2_up;
 
 namespace Matrix
 {
+	// Спрайт атласа, который выводится в слоте slot, пока виден слой layer.
+	struct sprite_bind_t
+	{
+		uint8_t layer;
+		uint8_t slot;
+		uint8_t sprite;
+		uint8_t script;
+		int16_t x;
+		int16_t y;
+	};
 
 	/* Настройки */
 	static constexpr uint8_t CFG_Layers = 8;		// Кол-во слоёв анимации.
@@ -15,10 +31,39 @@ namespace Matrix
 	static constexpr uint8_t CFG_Height = 16;		// Высота экрана.
 	static constexpr uint16_t CFG_Delay = 200;		// Интервал обновления экрана.
 	static constexpr uint8_t CFG_Brightness = 10;	// Яркость матрицы.
+	static constexpr uint8_t CFG_FadeFrames = 5;	// Длительность плавной смены изображения, кадров.
+	static constexpr uint16_t CFG_LayerArena = 2048;	// Память слоёв PXL2: буферы дельта-кадров и палитры, кэш и упреждающее чтение, байт.
+	static constexpr uint16_t CFG_LinkMap = 32;			// Таблицы кластеров файлов слоёв PXL2, элементов DWORD.
+	static constexpr uint16_t CFG_PackLinkMap = 16;		// Таблица кластеров пакета изображений, элементов DWORD.
+	static constexpr uint16_t CFG_DirIndex = 32;		// Файлов в индексе папки ROOT_DIRECTORY, по 10 байт.
+	static constexpr uint8_t CFG_SpriteSlots = 4;		// Кол-во одновременно показываемых спрайтов.
+	static constexpr uint16_t CFG_SpriteArena = 512;	// Память под пиксели спрайтов, байт.
+	// Спрайты слоёв: стрелки бегут от центра панели, спрайт и скрипт 0 - влево, 1 - вправо.
+	// Если слот нужен нескольким видимым слоям, в нём выводится спрайт последней из их строк.
+	static constexpr sprite_bind_t CFG_SpriteBinds[] =
+	{
+		{5, 0, 0, 0, 56, 4},	// Поворот влево.
+		{6, 1, 1, 1, 64, 4},	// Поворот вправо.
+		{7, 0, 0, 0, 56, 4},	// Аварийка.
+		{7, 1, 1, 1, 64, 4},
+	};
 	#define ROOT_DIRECTORY ("/pxl_r")				// Папка с файлами pxl.
+	#define SPRITES_ATLAS ("sprites.atl")			// Атлас спрайтов в папке ROOT_DIRECTORY.
+	#define ASSET_PACK ("assets.pak")				// Пакет изображений в папке ROOT_DIRECTORY.
 	/* */
 	
 	MatrixLed<CFG_Layers, CFG_Width, CFG_Height> matrixObj(CFG_Delay);
+	MatrixLayers<CFG_Layers, CFG_Width, CFG_Height, CFG_LayerArena, CFG_LinkMap> layersObj;
+	MatrixCanvas<CFG_Width, CFG_Height> canvasObj;
+	MatrixSprites<CFG_SpriteSlots, CFG_SpriteArena> spritesObj;
+	PxlPack<CFG_PackLinkMap> packObj;
+	PxlDirIndex<CFG_DirIndex> dirObj;
+	
+	uint32_t dir_build_time = 0;	// Время построения индекса папки, мс.
+	uint32_t image_reg_time = 0;	// Время последней регистрации изображения по номеру, мс.
+	DWORD sector_cache[2] = {};		// Попадания и промахи кэша секторов FAT драйвера карты.
+	uint8_t layers_visible = 0;		// Видимые слои, по биту на слой.
+	uint8_t sprite_binds[CFG_SpriteSlots] = {};	// Строка CFG_SpriteBinds + 1, спрайт которой выводится в слоте, 0 - никакой.
 	
 	uint8_t *frame_buffer_ptr;
 	uint16_t frame_buffer_len;
@@ -39,7 +84,8 @@ namespace Matrix
 
 #define TIM_NUM	   2  ///< Timer number
 #define TIM_CH	   TIM_CHANNEL_1  ///< Timer's PWM channel
-#define DMA_HANDLE hdma_tim2_ch1  ///< DMA Channel
+#define DMA_HANDLE hdma_tim2_up  ///< DMA Channel
+#define TIM_DMA_UP  ///< DMA request on timer update (TIM2_UP, DMA1 Channel2): TIM2_CH1 shares Channel5 with SPI2_TX
 
 /// Timer handler
 #if TIM_NUM == 1
@@ -125,6 +171,14 @@ void DMAInit()
 #define ARGB_TIM_CCR CCR4
 #endif
 
+// Запрос по обновлению: CCR с предзагрузкой всё равно применяется на следующем периоде, так что форма сигнала та же.
+#ifdef TIM_DMA_UP
+#undef ARGB_TIM_DMA_ID
+#undef ARGB_TIM_DMA_CC
+#define ARGB_TIM_DMA_ID TIM_DMA_ID_UPDATE
+#define ARGB_TIM_DMA_CC TIM_DMA_UPDATE
+#endif
+
 
 
 
@@ -317,6 +371,133 @@ static void RGB_TIM_DMADelayPulseCplt(DMA_HandleTypeDef *hdma) {
 
 
 
+// Файлы PXL2 проигрывает layersObj поверх кадра, остальные - matrixObj.
+inline void RegLayer(const char *filename, uint8_t id)
+{
+	if(layersObj.RegLayer(filename, id) == true)
+	{
+		matrixObj.HideLayer(id);
+	}
+	else
+	{
+		matrixObj.RegLayer(filename, id);
+	}
+	
+	return;
+}
+
+// Изображение номер entry (Pxl::PACK_*): из пакета, если он есть, затем из файла по индексу папки.
+// PXL-файлы MatrixLed<> открывает сам, поэтому им и всему, чего нет в индексе, остаётся поиск по имени.
+// Изображение из flash, если оно собрано в прошивку, - запасное: только когда на карте его нет
+// или карта не читается.
+inline void RegImage(uint16_t entry, const char *filename, uint8_t id)
+{
+	uint32_t time = HAL_GetTick();
+	Pxl::pack_entry_t info;
+	PxlFile file;
+	
+	if(packObj.GetEntry(entry, info) == true && layersObj.RegLayer(packObj.File(), info.offset, info.size, id) == true)
+	{
+		matrixObj.HideLayer(id);
+	}
+	else if(dirObj.Open(entry, file) == true && layersObj.RegLayer(file, id) == true)
+	{
+		matrixObj.HideLayer(id);
+	}
+	else if(file.Open(filename) == true)
+	{
+		file.Close();
+		RegLayer(filename, id);
+	}
+	else if(PxlFlash::Open(entry, file) == true && layersObj.RegLayer(file, id) == true)
+	{
+		matrixObj.HideLayer(id);
+	}
+	else
+	{
+		RegLayer(filename, id);
+	}
+	image_reg_time = HAL_GetTick() - time;
+	disk_ioctl(0, CTRL_CACHE_STATS, sector_cache);
+	
+	return;
+}
+
+// Показать в слотах спрайты видимых слоёв по CFG_SpriteBinds и убрать спрайты скрытых.
+inline void UpdateSprites()
+{
+	for(uint8_t slot = 0; slot < CFG_SpriteSlots; ++slot)
+	{
+		uint8_t bind = 0;
+		for(uint8_t i = 0; i < sizeof(CFG_SpriteBinds) / sizeof(CFG_SpriteBinds[0]); ++i)
+		{
+			if(CFG_SpriteBinds[i].slot == slot && (layers_visible & (1 << CFG_SpriteBinds[i].layer))) bind = i + 1;
+		}
+		if(bind == sprite_binds[slot]) continue;
+		
+		sprite_binds[slot] = bind;
+		if(bind == 0)
+		{
+			spritesObj.Hide(slot);
+		}
+		else
+		{
+			const sprite_bind_t &obj = CFG_SpriteBinds[bind - 1];
+			if(spritesObj.Show(slot, obj.sprite, obj.script, obj.x, obj.y) == false)
+			{
+				Logger.PrintTopic("PXL").Printf("Sprite %d of layer %d: not shown", obj.sprite, obj.layer).PrintNewLine();
+			}
+		}
+	}
+	
+	return;
+}
+
+inline void ShowLayer(uint8_t id)
+{
+	if(layersObj.IsRegistered(id) == true)
+	{
+		layersObj.ShowLayer(id);
+	}
+	else
+	{
+		matrixObj.ShowLayer(id);
+	}
+	layers_visible |= (1 << id);
+	UpdateSprites();
+	
+	return;
+}
+
+inline void HideLayer(uint8_t id)
+{
+	if(layersObj.IsRegistered(id) == true)
+	{
+		layersObj.HideLayer(id);
+	}
+	else
+	{
+		matrixObj.HideLayer(id);
+	}
+	layers_visible &= ~(1 << id);
+	UpdateSprites();
+	
+	return;
+}
+
+// Сменить изображение слоя (см. RegImage()) с плавным переходом за frames кадров: прежний источник PXL2
+// гаснет, новый проявляется, остальные слои и спрайты выводятся как обычно. Источник PXL проигрывает
+// MatrixLed<> под всеми слоями PXL2 и без прозрачности, поэтому он появляется и пропадает сразу.
+// Скрытие слоя прерывает переход.
+inline void SwapImage(uint16_t entry, const char *filename, uint8_t id, uint8_t frames)
+{
+	layersObj.StartTransition(id, frames);
+	RegImage(entry, filename, id);
+	ShowLayer(id);
+	
+	return;
+}
+
 inline void Setup()
 {
 
@@ -324,17 +505,36 @@ inline void Setup()
 	f_chdir(ROOT_DIRECTORY);
 #endif
 	
-	matrixObj.RegLayer("layer0.pxl", 0);	// 0 - Фон / Заливка;
-	matrixObj.RegLayer("layer1.pxl", 1);	// 1 - Анимация;
-	matrixObj.RegLayer("layer2.pxl", 2);	// 2 - Габариты;
-	matrixObj.RegLayer("layer3.pxl", 3);	// 3 - Задних ход;
-	matrixObj.RegLayer("layer4.pxl", 4);	// 4 - Стопы;
-	matrixObj.RegLayer("layer5.pxl", 5);	// 5 - Повтороты лево;
-	matrixObj.RegLayer("layer6.pxl", 6);	// 6 - Повтороты право;
-	matrixObj.RegLayer("layer7.pxl", 7);	// 7 - Аварийка;
-
-	matrixObj.ShowLayer(0);
-	matrixObj.ShowLayer(1);
+	// Слои берутся из пакета, если он есть, иначе из отдельных файлов.
+	packObj.Open(ASSET_PACK);
+	
+	dir_build_time = HAL_GetTick();
+	dirObj.Build("");
+	dir_build_time = HAL_GetTick() - dir_build_time;
+	Logger.PrintTopic("PXL").Printf("Dir index: %d files, %d ms%s", dirObj.Count(), dir_build_time, (dirObj.IsComplete() == true) ? "" : ", incomplete").PrintNewLine();
+	Logger.PrintTopic("PXL").Printf("Flash images: %d", PxlFlash::Count()).PrintNewLine();
+	
+	static const char *layer_files[CFG_Layers] =
+	{
+		"layer0.pxl",	// 0 - Фон / Заливка;
+		"layer1.pxl",	// 1 - Анимация;
+		"layer2.pxl",	// 2 - Габариты;
+		"layer3.pxl",	// 3 - Задних ход;
+		"layer4.pxl",	// 4 - Стопы;
+		"layer5.pxl",	// 5 - Повтороты лево;
+		"layer6.pxl",	// 6 - Повтороты право;
+		"layer7.pxl",	// 7 - Аварийка;
+	};
+	for(uint8_t i = 0; i < CFG_Layers; ++i)
+	{
+		RegImage(Pxl::PACK_LAYER + i, layer_files[i], i);
+	}
+
+	Logger.PrintTopic("PXL").Printf("Link map: %d of %d bytes, contiguous layers: %d, FAT fallback layers: %d", layersObj.LinkMapUsed(), (int)(CFG_LinkMap * sizeof(DWORD)), layersObj.ContiguousLayers(), layersObj.LinkMapFallbacks()).PrintNewLine();
+	Logger.PrintTopic("PXL").Printf("Sector cache: %d hits, %d misses", (int)sector_cache[0], (int)sector_cache[1]).PrintNewLine();
+
+	ShowLayer(0);
+	ShowLayer(1);
 	//matrixObj.ShowLayer(2);
 	//matrixObj.ShowLayer(3);
 	//matrixObj.ShowLayer(4);
@@ -342,9 +542,17 @@ inline void Setup()
 	//matrixObj.ShowLayer(6);
 	//matrixObj.ShowLayer(7);
 	
+	bool atlas = spritesObj.LoadAtlas(SPRITES_ATLAS);
+	Logger.PrintTopic("PXL").Printf("Sprites atlas: %s", (atlas == true) ? "loaded" : "none").PrintNewLine();
+	// Слои, показанные до загрузки атласа, получают свои спрайты сейчас.
+	memset(sprite_binds, 0x00, sizeof(sprite_binds));
+	UpdateSprites();
+	
 	matrixObj.SetBrightness(CFG_Brightness);
+	canvasObj.SetBrightness(CFG_Brightness);
 	
 	matrixObj.GetFrameBuffer(frame_buffer_ptr, frame_buffer_len);
+	canvasObj.Attach(frame_buffer_ptr, frame_buffer_len);
 
 	//matrixObj.ManualMode(true);
 	//matrixObj.DrawPixel(5, 0xFF0000FF);
@@ -371,7 +579,10 @@ inline void Loop(uint32_t &current_time)
 	
 	if(matrixObj.IsBufferReady() == true)
 	{
-		timer12 = timer2 - timer1;
+		layersObj.Render(canvasObj, current_time);
+		spritesObj.Render(canvasObj);
+		
+		timer12 = HAL_GetTick() - timer1;
 		timer23 = HAL_GetTick();
 		
 		matrixObj.SetFrameDrawStart();
@@ -381,6 +592,11 @@ inline void Loop(uint32_t &current_time)
 		//Serial::Print("+PXL=128,16,2\r\n");
 		//Serial::Print(frame_buffer_ptr, frame_buffer_len);
 	}
+	else
+	{
+		// Пока кадр не нужен, подчитываем с карты следующие кадры слоёв PXL2.
+		layersObj.Prefetch();
+	}
 	
 	if( matrixObj.GetFrameIsDraw() == true && frame_buffer_idx == 0 )
 	{
@@ -388,7 +604,7 @@ inline void Loop(uint32_t &current_time)
 		
 		timer23 = HAL_GetTick() - timer23;
 		//DEBUG_LOG_TOPIC("PXLTime", "render: %d ms, draw: %d ms, total: %d ms\n", timer12, timer23, (timer23 + timer12));
-		Logger.PrintTopic("PXLTime").Printf("render: %d ms, draw: %d ms, total: %d ms;\n", timer12, timer23, (timer23 + timer12));
+		Logger.PrintTopic("PXLTime").Printf("render: %d ms, draw: %d ms, total: %d ms, prefetch misses: %d of %d, cache: %d%% of reads, %d bytes;\n", timer12, timer23, (timer23 + timer12), (int)layersObj.PrefetchMisses(), (int)(layersObj.PrefetchMisses() + layersObj.PrefetchHits()), (int)(layersObj.CacheHits() * 100 / (layersObj.CacheHits() + layersObj.CacheMisses() + 1)), layersObj.CacheUsed());
 	}
 	
 	current_time = HAL_GetTick();
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <string.h>
+#include <PxlFormat.h>
+#include <PxlFile.h>
+
+/*
+	Спрайты из атласа на SD-карте.
+	Спрайт выводится поверх кадра в точку (x, y) с учётом прозрачности и обрезкой по краям
+	панели и двигается по скрипту из того же атласа. При показе пиксели спрайта и шаги скрипта
+	копируются в общий буфер размером _arenaSize, так что память зависит от размера спрайта, а не
+	панели, а Render() карту не читает.
+*/
+template <uint8_t _maxSlots, uint16_t _arenaSize>
+class MatrixSprites
+{
+	public:
+
+		bool LoadAtlas(const char *filename)
+		{
+			for(uint8_t i = 0; i < _maxSlots; ++i)
+			{
+				Hide(i);
+			}
+			if(_file.Open(filename) == false) return false;
+
+			if(_file.Read(0, &_header, sizeof(_header)) == false || memcmp(_header.magic, Pxl::ATLAS_MAGIC, sizeof(_header.magic)) != 0 || _header.version != Pxl::ATLAS_VERSION)
+			{
+				_file.Close();
+				return false;
+			}
+
+			return true;
+		}
+
+		bool Show(uint8_t slot, uint8_t sprite, uint8_t script, int16_t x, int16_t y)
+		{
+			if(_file.IsOpen() == false || slot >= _maxSlots) return false;
+			if(sprite >= _header.sprite_count || script >= _header.script_count) return false;
+
+			Hide(slot);
+
+			slot_t &obj = _slots[slot];
+			uint32_t offset = sizeof(Pxl::atlas_header_t) + sprite * sizeof(Pxl::sprite_desc_t);
+			if(_file.Read(offset, &obj.sprite, sizeof(obj.sprite)) == false) return false;
+
+			offset = sizeof(Pxl::atlas_header_t) + _header.sprite_count * sizeof(Pxl::sprite_desc_t) + script * sizeof(Pxl::script_desc_t);
+			if(_file.Read(offset, &obj.script, sizeof(obj.script)) == false || obj.script.step_count == 0) return false;
+			if(obj.sprite.frames == 0) return false;
+
+			uint32_t pixels = (uint32_t)obj.sprite.width * obj.sprite.height * obj.sprite.frames * sizeof(Pxl::rgba_t);
+			uint32_t steps = (uint32_t)obj.script.step_count * sizeof(Pxl::script_step_t);
+			if(pixels + steps > (uint32_t)(_arenaSize - _arenaUsed)) return false;
+
+			if(_file.Read(obj.sprite.offset, &_arena[_arenaUsed], pixels) == false) return false;
+			if(_file.Read(obj.script.offset, &_arena[_arenaUsed + pixels], steps) == false) return false;
+
+			obj.arena_offset = _arenaUsed;
+			obj.arena_size = pixels + steps;
+			obj.steps_offset = _arenaUsed + pixels;
+			_arenaUsed += pixels + steps;
+			_LoadStep(obj, 0);
+
+			obj.start_x = obj.x = x;
+			obj.start_y = obj.y = y;
+			obj.frame = 0;
+			obj.active = true;
+
+			return true;
+		}
+
+		void Hide(uint8_t slot)
+		{
+			if(slot >= _maxSlots || _slots[slot].active == false) return;
+
+			slot_t &obj = _slots[slot];
+			uint16_t tail = obj.arena_offset + obj.arena_size;
+			memmove(&_arena[obj.arena_offset], &_arena[tail], _arenaUsed - tail);
+			for(slot_t &other : _slots)
+			{
+				if(other.active == true && other.arena_offset > obj.arena_offset)
+				{
+					other.arena_offset -= obj.arena_size;
+					other.steps_offset -= obj.arena_size;
+				}
+			}
+			_arenaUsed -= obj.arena_size;
+			obj.active = false;
+
+			return;
+		}
+
+		bool IsActive(uint8_t slot) const
+		{
+			return (slot < _maxSlots && _slots[slot].active == true);
+		}
+
+		// Вывести все активные спрайты и сдвинуть их на один шаг скрипта.
+		template <class canvas_t>
+		void Render(canvas_t &canvas)
+		{
+			for(uint8_t i = 0; i < _maxSlots; ++i)
+			{
+				slot_t &obj = _slots[i];
+				if(obj.active == false) continue;
+
+				uint8_t frame = obj.frame;
+				if(obj.step.sprite_frame != Pxl::STEP_FRAME_CYCLE)
+				{
+					frame = (obj.step.sprite_frame < obj.sprite.frames) ? obj.step.sprite_frame : (obj.sprite.frames - 1);
+				}
+
+				uint16_t frame_pixels = obj.sprite.width * obj.sprite.height;
+				const Pxl::rgba_t *pixels = (const Pxl::rgba_t *)&_arena[obj.arena_offset] + frame * frame_pixels;
+				for(uint8_t row = 0; row < obj.sprite.height; ++row)
+				{
+					canvas.BlendRow(obj.x, obj.y + row, pixels, obj.sprite.width);
+					pixels += obj.sprite.width;
+				}
+
+				_Advance(i);
+			}
+
+			return;
+		}
+
+	private:
+
+		struct slot_t
+		{
+			Pxl::sprite_desc_t sprite;
+			Pxl::script_desc_t script;
+			Pxl::script_step_t step;
+			uint16_t arena_offset;			// Пиксели всех кадров, затем шаги скрипта.
+			uint16_t arena_size;
+			uint16_t steps_offset;
+			int16_t start_x;
+			int16_t start_y;
+			int16_t x;
+			int16_t y;
+			uint8_t step_idx;
+			uint8_t step_tick;
+			uint8_t frame;
+			bool active;
+		};
+
+		void _Advance(uint8_t slot)
+		{
+			slot_t &obj = _slots[slot];
+
+			obj.x += obj.step.dx;
+			obj.y += obj.step.dy;
+			if(++obj.frame >= obj.sprite.frames) obj.frame = 0;
+
+			if(++obj.step_tick < obj.step.frames) return;
+
+			if(obj.step_idx + 1 < obj.script.step_count)
+			{
+				_LoadStep(obj, obj.step_idx + 1);
+			}
+			else if(obj.script.flags & Pxl::SCRIPT_FLAG_LOOP)
+			{
+				obj.x = obj.start_x;
+				obj.y = obj.start_y;
+				_LoadStep(obj, 0);
+			}
+			else
+			{
+				Hide(slot);
+			}
+
+			return;
+		}
+
+		void _LoadStep(slot_t &obj, uint8_t idx)
+		{
+			memcpy(&obj.step, &_arena[obj.steps_offset + idx * sizeof(Pxl::script_step_t)], sizeof(obj.step));
+			if(obj.step.frames == 0) obj.step.frames = 1;
+
+			obj.step_idx = idx;
+			obj.step_tick = 0;
+
+			return;
+		}
+
+		PxlFile _file;
+		Pxl::atlas_header_t _header;
+
+		slot_t _slots[_maxSlots] = {};
+		uint8_t _arena[_arenaSize];
+		uint16_t _arenaUsed = 0;
+};
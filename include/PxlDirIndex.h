@@ -0,0 +1,190 @@
+#pragma once
+
+#include <string.h>
+#include <PxlFormat.h>
+#include <PxlFile.h>
+
+/*
+	Индекс папки с изображениями: номер изображения -> первый кластер и размер файла.
+	Строится одним проходом по записям каталога при старте, после чего файл открывается
+	по кластеру без поиска по имени. Номера те же, что в пакете изображений:
+	layerN.pxl - Pxl::PACK_LAYER + N, userNNN.pxl - Pxl::PACK_USER + NNN - 1.
+	В памяти только найденные файлы, по возрастанию номера, не больше _capacity.
+*/
+template <uint16_t _capacity>
+class PxlDirIndex
+{
+	public:
+
+		// path - папка, "" - текущая.
+		bool Build(const char *path)
+		{
+			DIR dir;
+			_count = 0;
+			_overflow = false;
+			_ready = false;
+
+			if(f_opendir(&dir, path) != FR_OK) return false;
+
+			FATFS *fs = dir.fs;
+			DWORD sclust = dir.sclust;
+			if(sclust == 0 && fs->fs_type == FS_FAT32) sclust = fs->dirbase;
+			if(sclust == 0)
+			{
+				// Корневой каталог FAT12/16: n_rootdir записей в секторах подряд с dirbase, через окно FATFS.
+				const uint16_t records = _SectorSize(fs) / 32;
+				for(uint16_t i = 0; i < fs->n_rootdir; ++i)
+				{
+					DWORD sector = fs->dirbase + i / records;
+					if(fs->winsect != sector)
+					{
+						fs->winsect = 0xFFFFFFFF;
+						if(disk_read(fs->drv, fs->win.d8, sector, 1) != RES_OK) return false;
+						fs->winsect = sector;
+					}
+					if(_Record(fs, &fs->win.d8[(i % records) * 32]) == false) break;
+				}
+			}
+			else
+			{
+				// Каталог читается как файл неизвестного размера до записи-терминатора или конца цепочки.
+				PxlFile file;
+				if(file.Open(fs, sclust, 0xFFFFFFFF) == false) return false;
+
+				uint8_t record[32];
+				for(uint32_t offset = 0; file.Read(offset, record, sizeof(record)) == true; offset += sizeof(record))
+				{
+					if(_Record(fs, record) == false) break;
+				}
+				file.Close();
+			}
+			_fs = fs;
+			_ready = true;
+
+			return true;
+		}
+
+		bool IsReady() const
+		{
+			return _ready;
+		}
+
+		// Найдены все файлы папки: если номера нет в индексе, то нет и файла.
+		bool IsComplete() const
+		{
+			return (_ready == true && _overflow == false);
+		}
+
+		uint16_t Count() const
+		{
+			return _count;
+		}
+
+		bool Open(uint16_t idx, PxlFile &file) const
+		{
+			if(_ready == false) return false;
+
+			uint16_t from = 0;
+			uint16_t to = _count;
+			while(from < to)
+			{
+				uint16_t mid = (from + to) / 2;
+				if(_entries[mid].idx < idx) from = mid + 1;
+				else to = mid;
+			}
+			if(from >= _count || _entries[from].idx != idx) return false;
+
+			return file.Open(_fs, _entries[from].sclust, _entries[from].size);
+		}
+
+	private:
+
+		struct __attribute__((__packed__)) entry_t
+		{
+			uint16_t idx;
+			uint32_t sclust;
+			uint32_t size;
+		};
+		static_assert(sizeof(entry_t) == 10, "CFG_DirIndex and README count 10 bytes per entry");
+
+		static uint16_t _SectorSize(const FATFS *fs)
+		{
+#if _MAX_SS != _MIN_SS
+			return fs->ssize;
+#else
+			return _MAX_SS;
+#endif
+		}
+
+		// Запись каталога в индекс, если это файл изображения. false - конец каталога.
+		bool _Record(const FATFS *fs, const uint8_t *record)
+		{
+			if(record[0] == 0x00) return false;
+			if(record[0] == 0xE5 || (record[11] & (AM_VOL | AM_DIR)) != 0) return true;
+
+			uint16_t idx;
+			if(_ParseName(record, idx) == false) return true;
+
+			entry_t entry;
+			entry.idx = idx;
+			entry.sclust = record[26] | (record[27] << 8);
+			if(fs->fs_type == FS_FAT32) entry.sclust |= (DWORD)(record[20] | (record[21] << 8)) << 16;
+			entry.size = record[28] | (record[29] << 8) | ((DWORD)record[30] << 16) | ((DWORD)record[31] << 24);
+			_Insert(entry);
+
+			return true;
+		}
+
+		// Имя 8.3 в записи каталога: "LAYERN  PXL" или "USERNNN PXL".
+		static bool _ParseName(const uint8_t *name, uint16_t &idx)
+		{
+			if(memcmp(&name[8], "PXL", 3) != 0) return false;
+
+			if(memcmp(name, "LAYER", 5) == 0 && name[5] >= '0' && name[5] <= '7' && name[6] == ' ' && name[7] == ' ')
+			{
+				idx = Pxl::PACK_LAYER + (name[5] - '0');
+				return true;
+			}
+			if(memcmp(name, "USER", 4) == 0 && name[7] == ' ')
+			{
+				uint16_t number = 0;
+				for(uint8_t i = 4; i < 7; ++i)
+				{
+					if(name[i] < '0' || name[i] > '9') return false;
+					number = number * 10 + (name[i] - '0');
+				}
+				if(number == 0 || number > 255) return false;
+
+				idx = Pxl::PACK_USER + number - 1;
+				return true;
+			}
+
+			return false;
+		}
+
+		void _Insert(const entry_t &entry)
+		{
+			if(_count >= _capacity)
+			{
+				_overflow = true;
+				return;
+			}
+
+			uint16_t pos = _count;
+			while(pos > 0 && _entries[pos - 1].idx > entry.idx)
+			{
+				_entries[pos] = _entries[pos - 1];
+				--pos;
+			}
+			_entries[pos] = entry;
+			++_count;
+
+			return;
+		}
+
+		FATFS *_fs = nullptr;
+		entry_t _entries[_capacity];
+		uint16_t _count = 0;
+		bool _overflow = false;
+		bool _ready = false;
+};
@@ -0,0 +1,384 @@
+#pragma once
+
+#include <string.h>
+#include "ff.h"
+#include "diskio.h"
+
+/*
+	Файл с данными слоя или спрайтов: чтение блока по смещению от начала файла.
+	С таблицей кластеров (FatFs fast seek) переход по файлу и переход на следующий кластер
+	не читают FAT с карты. Непрерывный файл читается прямо по номерам секторов через disk_read.
+	Файл может быть частью другого открытого файла (пакета): объект FIL копируется вместе
+	с таблицей кластеров, смещения отсчитываются от начала части.
+	Map() даёт данные прямо в окне сектора FatFs (при _FS_TINY оно одно на том), без копирования.
+	Файл может быть и массивом во внутренней flash (PxlFlash.h), тогда карта не используется.
+*/
+class PxlFile
+{
+	public:
+
+		// Состояние асинхронного чтения ReadStart() / ReadPoll().
+		struct async_t
+		{
+			DISK_READ_ASYNC disk;
+			FATFS *fs;
+			DWORD sector;				// Первый сектор файла.
+			uint8_t *buffer;
+			uint32_t offset;			// Смещение в файле с учётом начала части.
+			uint32_t length;			// Осталось прочитать.
+			uint32_t count;				// Байт в запросе к карте, 0 - запроса нет.
+			bool window;				// Запрос читает сектор в окно FATFS.
+			bool active;
+		};
+
+		bool Open(const char *filename)
+		{
+			Close();
+
+			if(f_open(&_file, filename, FA_READ) != FR_OK) return false;
+			_opened = true;
+
+			return true;
+		}
+
+		// Открыть файл по первому кластеру и размеру из записи каталога, без поиска по имени.
+		bool Open(FATFS *fs, DWORD sclust, DWORD size)
+		{
+			Close();
+
+			if(fs == nullptr || fs->fs_type == 0 || (sclust < 2 && size > 0)) return false;
+			memset(&_file, 0x00, sizeof(_file));
+			_file.fs = fs;
+			_file.id = fs->id;
+			_file.flag = FA_READ;
+			_file.fsize = size;
+			_file.sclust = sclust;
+			_opened = true;
+
+			return true;
+		}
+
+		// Массив во flash.
+		bool Open(const uint8_t *data, uint32_t size)
+		{
+			Close();
+
+			if(data == nullptr || size == 0) return false;
+			_memory = data;
+			_length = size;
+			_opened = true;
+
+			return true;
+		}
+
+		bool Open(const PxlFile &source, uint32_t offset, uint32_t length)
+		{
+			Close();
+
+			if(source._opened == false || offset > source.Size() || length > source.Size() - offset) return false;
+			_file = source._file;
+			_memory = source._memory;
+			_sector = source._sector;
+			_base = source._base + offset;
+			_length = length;
+			_opened = true;
+
+			return true;
+		}
+
+		bool IsPart() const
+		{
+			return (_length > 0 && _memory == nullptr);
+		}
+
+		bool IsMemory() const
+		{
+			return (_memory != nullptr);
+		}
+
+		/*
+			Построить таблицу кластеров файла в table из length элементов.
+			Возвращает кол-во элементов, которое заняла бы таблица, или 0 при ошибке.
+			Если таблица не поместилась, файл читается по цепочке FAT, как без неё.
+		*/
+		uint32_t LinkMap(DWORD *table, uint32_t length)
+		{
+			_file.cltbl = nullptr;
+			_sector = 0;
+			if(_opened == false || _memory != nullptr || table == nullptr || length < 2) return 0;
+
+			table[0] = length;
+			_file.cltbl = table;
+			FRESULT res = f_lseek(&_file, CREATE_LINKMAP);
+			if(res != FR_OK || table[0] <= 2) _file.cltbl = nullptr;
+
+			// Один фрагмент: файл непрерывный, таблица ему больше не нужна.
+			if(res == FR_OK && table[0] == 4)
+			{
+				_sector = _file.fs->database + (table[2] - 2) * _file.fs->csize;
+				_file.cltbl = nullptr;
+			}
+
+			return (res == FR_OK || res == FR_NOT_ENOUGH_CORE) ? table[0] : 0;
+		}
+
+		// Файл читается напрямую по секторам, определяется в LinkMap().
+		bool IsContiguous() const
+		{
+			return (_sector > 0);
+		}
+
+		// Таблица кластеров перенесена в памяти.
+		void MoveLinkMap(DWORD *table)
+		{
+			if(_file.cltbl != nullptr) _file.cltbl = table;
+
+			return;
+		}
+
+		void Close()
+		{
+			if(_opened == false) return;
+
+			if(_memory == nullptr) f_close(&_file);
+			_memory = nullptr;
+			_sector = 0;
+			_base = 0;
+			_length = 0;
+			_opened = false;
+
+			return;
+		}
+
+		bool IsOpen() const
+		{
+			return _opened;
+		}
+
+		uint32_t Size() const
+		{
+			if(_opened == false) return 0;
+
+			return (_length > 0) ? _length : f_size(&_file);
+		}
+
+		bool Read(uint32_t offset, void *buffer, uint32_t length)
+		{
+			UINT readed = 0;
+			if(_opened == false) return false;
+			if(_length > 0)
+			{
+				if(offset > _length || length > _length - offset) return false;
+				offset += _base;
+			}
+			if(_memory != nullptr)
+			{
+				memcpy(buffer, &_memory[offset], length);
+				return true;
+			}
+			if(_sector > 0) return _ReadDirect(offset, (uint8_t *)buffer, length);
+			if(f_tell(&_file) != offset && f_lseek(&_file, offset) != FR_OK) return false;
+			if(f_read(&_file, buffer, length, &readed) != FR_OK) return false;
+
+			return (readed == length);
+		}
+
+		/*
+			Данные с offset до конца сектора (и файла) в окне FATFS.win: data - указатель на байт offset,
+			length - сколько байт доступно. Окно действительно до следующего чтения с карты.
+			Неполный сектор и f_read, и _ReadDirect() читают через окно, так что достаточно прочитать один байт.
+		*/
+		bool Map(uint32_t offset, const uint8_t *&data, uint32_t &length)
+		{
+			if(_memory != nullptr)
+			{
+				if(offset >= _length) return false;
+				data = &_memory[_base + offset];
+				length = _length - offset;
+				return true;
+			}
+
+			uint8_t byte;
+			if(Read(offset, &byte, sizeof(byte)) == false) return false;
+
+			FATFS *fs = _file.fs;
+			uint32_t end = Size() - offset;
+			offset += _base;
+			data = &fs->win.d8[offset % _SectorSize(fs)];
+			length = _SectorSize(fs) - offset % _SectorSize(fs);
+			if(length > end) length = end;
+
+			return true;
+		}
+
+		/*
+			Асинхронное чтение непрерывного файла: false, если файл читается не по секторам, тогда - Read().
+			Сектора запрашиваются у карты (CTRL_READ_START), и пока она их готовит, ReadPoll() возвращает
+			управление. Целые сектора читаются сразу в buffer, неполные - в окно FATFS. Пока сектор
+			загружается в окно, номер сектора окна недействителен, поэтому FatFs и Read() его не используют,
+			а если за это время окно заняли, сектор запрашивается снова.
+		*/
+		bool ReadStart(async_t &read, uint32_t offset, void *buffer, uint32_t length) const
+		{
+			if(_opened == false || _sector == 0) return false;
+			if(_length > 0)
+			{
+				if(offset > _length || length > _length - offset) return false;
+				offset += _base;
+			}
+			if(offset > f_size(&_file) || length > f_size(&_file) - offset) return false;
+
+			read.fs = _file.fs;
+			read.sector = _sector;
+			read.buffer = (uint8_t *)buffer;
+			read.offset = offset;
+			read.length = length;
+			read.count = 0;
+			read.active = true;
+
+			return true;
+		}
+
+		// 1 - чтение идёт, 0 - данные прочитаны, -1 - ошибка. Файл к этому времени может быть уже закрыт.
+		static int8_t ReadPoll(async_t &read)
+		{
+			FATFS *fs = read.fs;
+			if(read.active == false) return -1;
+
+			while(true)
+			{
+				if(read.count > 0)
+				{
+					if(read.disk.busy != 0)
+					{
+						disk_ioctl(fs->drv, CTRL_READ_POLL, &read.disk);
+						if(read.disk.busy != 0) return 1;
+					}
+					if(read.disk.res != RES_OK)
+					{
+						if(fs->winsect == _WindowLoading) fs->winsect = 0xFFFFFFFF;
+						read.active = false;
+						return -1;
+					}
+					if(read.window == true)
+					{
+						if(fs->winsect != _WindowLoading)
+						{
+							read.count = 0;
+							continue;
+						}
+						fs->winsect = read.disk.sector;
+						memcpy(read.buffer, &fs->win.d8[read.offset % _SectorSize(fs)], read.count);
+					}
+					read.offset += read.count;
+					read.buffer += read.count;
+					read.length -= read.count;
+					read.count = 0;
+				}
+				if(read.length == 0)
+				{
+					read.active = false;
+					return 0;
+				}
+
+				DWORD sector = read.sector + read.offset / _SectorSize(fs);
+				uint16_t skip = read.offset % _SectorSize(fs);
+				uint32_t count = _SectorSize(fs) - skip;
+				if(count > read.length) count = read.length;
+
+				if(count == _SectorSize(fs))
+				{
+					count = read.length - read.length % _SectorSize(fs);
+					read.disk.buff = read.buffer;
+					read.disk.count = count / _SectorSize(fs);
+					read.window = false;
+				}
+				else if(fs->winsect == sector)
+				{
+					memcpy(read.buffer, &fs->win.d8[skip], count);
+					read.offset += count;
+					read.buffer += count;
+					read.length -= count;
+					continue;
+				}
+				else
+				{
+					fs->winsect = _WindowLoading;
+					read.disk.buff = fs->win.d8;
+					read.disk.count = 1;
+					read.window = true;
+				}
+				read.disk.sector = sector;
+				if(disk_ioctl(fs->drv, CTRL_READ_START, &read.disk) != RES_OK)
+				{
+					if(read.window == true) fs->winsect = 0xFFFFFFFF;
+					read.active = false;
+					return -1;
+				}
+				read.count = count;
+
+				return 1;
+			}
+		}
+
+	private:
+
+		// Номер сектора окна FATFS, пока в него идёт асинхронное чтение: не совпадает ни с одним сектором.
+		static constexpr DWORD _WindowLoading = 0xFFFFFFFE;
+
+		// Целые сектора читаются сразу в buffer, неполные - через окно FATFS с учётом winsect,
+		// как это делает f_read при _FS_TINY, поэтому кэш FatFs остаётся согласованным.
+		bool _ReadDirect(uint32_t offset, uint8_t *buffer, uint32_t length)
+		{
+			FATFS *fs = _file.fs;
+			if(offset > f_size(&_file) || length > f_size(&_file) - offset) return false;
+
+			while(length > 0)
+			{
+				DWORD sector = _sector + offset / _SectorSize(fs);
+				uint16_t skip = offset % _SectorSize(fs);
+				uint32_t count = _SectorSize(fs) - skip;
+				if(count > length) count = length;
+
+				// Подряд идущие целые сектора - одним чтением (CMD18 на карте).
+				if(count == _SectorSize(fs))
+				{
+					count = length - length % _SectorSize(fs);
+					if(disk_read(fs->drv, buffer, sector, count / _SectorSize(fs)) != RES_OK) return false;
+				}
+				else
+				{
+					if(fs->winsect != sector)
+					{
+						fs->winsect = 0xFFFFFFFF;
+						if(disk_read(fs->drv, fs->win.d8, sector, 1) != RES_OK) return false;
+						fs->winsect = sector;
+					}
+					memcpy(buffer, &fs->win.d8[skip], count);
+				}
+
+				offset += count;
+				buffer += count;
+				length -= count;
+			}
+
+			return true;
+		}
+
+		static uint16_t _SectorSize(const FATFS *fs)
+		{
+#if _MAX_SS != _MIN_SS
+			return fs->ssize;
+#else
+			(void)fs;
+			return _MAX_SS;
+#endif
+		}
+
+		FIL _file;
+		const uint8_t *_memory = nullptr;	// Данные во flash, nullptr - файл на карте.
+		DWORD _sector = 0;			// Первый сектор непрерывного файла, 0 - читать через FatFs.
+		uint32_t _base = 0;			// Начало части в файле.
+		uint32_t _length = 0;		// Размер части или массива, 0 - файл целиком.
+		bool _opened = false;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <PxlFormat.h>
+#include <PxlFile.h>
+
+/*
+	Изображения во внутренней flash: работают без SD-карты и открываются без чтения с неё.
+	Массивы собирает tools/flash_images.py из файлов папки flash проекта
+	(layerN.pxl, userNNN.pxl) в PxlFlashData.h, номер изображения тот же, что в пакете. Запасные:
+	RegImage() берёт их, только когда изображения нет на карте.
+*/
+namespace PxlFlash
+{
+	struct image_t
+	{
+		uint16_t entry;				// Pxl::PACK_LAYER + N или Pxl::PACK_USER + NNN - 1.
+		const uint8_t *data;		// Файл PXL2, nullptr - конец списка.
+		uint32_t size;
+	};
+}
+
+#include <PxlFlashData.h>
+
+namespace PxlFlash
+{
+	inline bool Open(uint16_t entry, PxlFile &file)
+	{
+		for(const image_t &image : images)
+		{
+			if(image.data != nullptr && image.entry == entry) return file.Open(image.data, image.size);
+		}
+
+		return false;
+	}
+
+	inline uint16_t Count()
+	{
+		return sizeof(images) / sizeof(images[0]) - 1;
+	}
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+// Сгенерировано tools/flash_images.py из папки flash, не редактировать.
+
+namespace PxlFlash
+{
+	// layer4.pxl, 106 bytes.
+	static constexpr uint8_t image_0[] =
+	{
+		0x50, 0x58, 0x4C, 0x32, 0x01, 0x00, 0x22, 0x00, 0x80, 0x10, 0x01, 0x00, 0xE8, 0x03, 0x01, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x64, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x40, 0x00, 0x7F, 0x7F, 0xFF, 0xFF, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0xFF,
+		0xFF, 0xFF, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0xFF, 0xFF,
+		0xFF, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0xFF, 0xFF, 0xFF,
+		0x00, 0x00, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0x00,
+		0x00, 0xFF, 0x7F, 0x7F, 0x22, 0x00, 0x00, 0x00, 0x00, 0x00,
+	};
+
+	// layer5.pxl, 222 bytes.
+	static constexpr uint8_t image_1[] =
+	{
+		0x50, 0x58, 0x4C, 0x32, 0x01, 0x00, 0x22, 0x00, 0x80, 0x10, 0x05, 0x00, 0xC8, 0x00, 0x01, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xC0, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x28, 0x00, 0x2A, 0x94, 0xFF, 0x8C, 0x00, 0xFF, 0x3F, 0x2A, 0x94, 0xFF, 0x8C, 0x00,
+		0xFF, 0x3F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x2A, 0x94,
+		0xFF, 0x8C, 0x00, 0xFF, 0x3F, 0x2A, 0x94, 0xFF, 0x8C, 0x00, 0xFF, 0x3F, 0x28, 0x00, 0x15, 0xA9,
+		0xFF, 0x8C, 0x00, 0xFF, 0x3F, 0x15, 0xA9, 0xFF, 0x8C, 0x00, 0xFF, 0x3F, 0x7F, 0x7F, 0x7F, 0x7F,
+		0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x15, 0xA9, 0xFF, 0x8C, 0x00, 0xFF, 0x3F, 0x15,
+		0xA9, 0xFF, 0x8C, 0x00, 0xFF, 0x3F, 0x24, 0x00, 0xBF, 0xFF, 0x8C, 0x00, 0xFF, 0x3F, 0xBF, 0xFF,
+		0x8C, 0x00, 0xFF, 0x3F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F,
+		0xBF, 0xFF, 0x8C, 0x00, 0xFF, 0x3F, 0xBF, 0xFF, 0x8C, 0x00, 0xFF, 0x3F, 0x10, 0x00, 0x7F, 0x7F,
+		0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x10, 0x00,
+		0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F,
+		0x22, 0x00, 0x00, 0x00, 0x00, 0x00, 0x4C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x76, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x9C, 0x00, 0x00, 0x00, 0x00, 0x00, 0xAE, 0x00, 0x00, 0x00, 0x00, 0x00,
+	};
+
+	// layer6.pxl, 222 bytes.
+	static constexpr uint8_t image_2[] =
+	{
+		0x50, 0x58, 0x4C, 0x32, 0x01, 0x00, 0x22, 0x00, 0x80, 0x10, 0x05, 0x00, 0xC8, 0x00, 0x01, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xC0, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x28, 0x00, 0x3F, 0x94, 0xFF, 0x8C, 0x00, 0xFF, 0x2A, 0x3F, 0x94, 0xFF, 0x8C, 0x00,
+		0xFF, 0x2A, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x3F, 0x94,
+		0xFF, 0x8C, 0x00, 0xFF, 0x2A, 0x3F, 0x94, 0xFF, 0x8C, 0x00, 0xFF, 0x2A, 0x28, 0x00, 0x3F, 0xA9,
+		0xFF, 0x8C, 0x00, 0xFF, 0x15, 0x3F, 0xA9, 0xFF, 0x8C, 0x00, 0xFF, 0x15, 0x7F, 0x7F, 0x7F, 0x7F,
+		0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x3F, 0xA9, 0xFF, 0x8C, 0x00, 0xFF, 0x15, 0x3F,
+		0xA9, 0xFF, 0x8C, 0x00, 0xFF, 0x15, 0x24, 0x00, 0x3F, 0xBF, 0xFF, 0x8C, 0x00, 0xFF, 0x3F, 0xBF,
+		0xFF, 0x8C, 0x00, 0xFF, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F,
+		0x3F, 0xBF, 0xFF, 0x8C, 0x00, 0xFF, 0x3F, 0xBF, 0xFF, 0x8C, 0x00, 0xFF, 0x10, 0x00, 0x7F, 0x7F,
+		0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x10, 0x00,
+		0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F,
+		0x22, 0x00, 0x00, 0x00, 0x00, 0x00, 0x4C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x76, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x9C, 0x00, 0x00, 0x00, 0x00, 0x00, 0xAE, 0x00, 0x00, 0x00, 0x00, 0x00,
+	};
+
+	// layer7.pxl, 218 bytes.
+	static constexpr uint8_t image_3[] =
+	{
+		0x50, 0x58, 0x4C, 0x32, 0x01, 0x00, 0x22, 0x00, 0x80, 0x10, 0x05, 0x00, 0xC8, 0x00, 0x01, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xBC, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x28, 0x00, 0x2A, 0xA9, 0xFF, 0x8C, 0x00, 0xFF, 0x2A, 0x2A, 0xA9, 0xFF, 0x8C, 0x00,
+		0xFF, 0x2A, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x2A, 0xA9,
+		0xFF, 0x8C, 0x00, 0xFF, 0x2A, 0x2A, 0xA9, 0xFF, 0x8C, 0x00, 0xFF, 0x2A, 0x28, 0x00, 0x15, 0xD3,
+		0xFF, 0x8C, 0x00, 0xFF, 0x15, 0x15, 0xD3, 0xFF, 0x8C, 0x00, 0xFF, 0x15, 0x7F, 0x7F, 0x7F, 0x7F,
+		0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x15, 0xD3, 0xFF, 0x8C, 0x00, 0xFF, 0x15, 0x15,
+		0xD3, 0xFF, 0x8C, 0x00, 0xFF, 0x15, 0x20, 0x00, 0xFF, 0xFF, 0x8C, 0x00, 0xFF, 0xFF, 0xFF, 0x8C,
+		0x00, 0xFF, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0xFF, 0xFF,
+		0x8C, 0x00, 0xFF, 0xFF, 0xFF, 0x8C, 0x00, 0xFF, 0x10, 0x00, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F,
+		0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x10, 0x00, 0x7F, 0x7F, 0x7F, 0x7F,
+		0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x22, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x4C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x76, 0x00, 0x00, 0x00, 0x00, 0x00, 0x98, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0xAA, 0x00, 0x00, 0x00, 0x00, 0x00,
+	};
+
+	static constexpr image_t images[] =
+	{
+		{4, image_0, sizeof(image_0)},
+		{5, image_1, sizeof(image_1)},
+		{6, image_2, sizeof(image_2)},
+		{7, image_3, sizeof(image_3)},
+		{0xFFFF, nullptr, 0},
+	};
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+	Форматы файлов на SD-карте, которые читает прошивка помимо PXL-файлов MatrixLed<>.
+	Заголовок подключается и host-утилитами, поэтому здесь только stdint.
+	Все многобайтовые поля - little-endian, структуры упакованы.
+*/
+namespace Pxl
+{
+	// Пиксель в файле: цвет и прозрачность (0 - прозрачный, 255 - непрозрачный).
+	struct __attribute__((__packed__)) rgba_t
+	{
+		uint8_t r;
+		uint8_t g;
+		uint8_t b;
+		uint8_t a;
+	};
+
+
+	/*
+		Атлас спрайтов.
+		[atlas_header_t][sprite_desc_t x sprite_count][script_desc_t x script_count][данные]
+		Пиксели спрайта: rgba_t[frames][height][width], строки сверху вниз.
+		Шаги скрипта: script_step_t[step_count].
+	*/
+	static constexpr char ATLAS_MAGIC[4] = {'S', 'P', 'R', 'A'};
+	static constexpr uint8_t ATLAS_VERSION = 1;
+
+	struct __attribute__((__packed__)) atlas_header_t
+	{
+		char magic[4];				// ATLAS_MAGIC.
+		uint8_t version;			// ATLAS_VERSION.
+		uint8_t sprite_count;		// Кол-во спрайтов.
+		uint8_t script_count;		// Кол-во скриптов движения.
+		uint8_t reserved;
+	};
+
+	struct __attribute__((__packed__)) sprite_desc_t
+	{
+		uint8_t width;
+		uint8_t height;
+		uint8_t frames;				// Кол-во кадров спрайта.
+		uint8_t reserved;
+		uint32_t offset;			// Смещение пикселей от начала файла.
+	};
+
+	static constexpr uint8_t SCRIPT_FLAG_LOOP = 0x01;	// По окончании начать сначала с исходной точки.
+
+	struct __attribute__((__packed__)) script_desc_t
+	{
+		uint8_t step_count;
+		uint8_t flags;				// SCRIPT_FLAG_*.
+		uint16_t reserved;
+		uint32_t offset;			// Смещение шагов от начала файла.
+	};
+
+	static constexpr uint8_t STEP_FRAME_CYCLE = 0xFF;	// Листать кадры спрайта по кругу.
+
+	// Шаг скрипта: в течение frames кадров вывода спрайт смещается на (dx, dy) за кадр.
+	struct __attribute__((__packed__)) script_step_t
+	{
+		int8_t dx;
+		int8_t dy;
+		uint8_t frames;				// Длительность шага в кадрах вывода.
+		uint8_t sprite_frame;		// Кадр спрайта или STEP_FRAME_CYCLE.
+	};
+
+
+	/*
+		Слой в формате PXL2, его проигрывает MatrixLayers<>. Файлы других форматов остаются MatrixLed<>.
+		[layer_header_t][rgba_t x palette_count][кадры]
+		Поля заголовка только добавляются в конец: header_size - фактический размер заголовка
+		в файле, отсутствующие в нём поля читаются как нули.
+	*/
+	static constexpr char LAYER_MAGIC[4] = {'P', 'X', 'L', '2'};
+	static constexpr uint8_t LAYER_VERSION = 1;
+
+	static constexpr uint8_t LAYER_FLAG_TWEEN = 0x01;	// Плавный переход между соседними кадрами.
+
+	enum encoding_t : uint8_t
+	{
+		ENCODING_RGBA = 0,			// rgba_t[frames][height][width].
+		ENCODING_RLE = 1,			// Кадры подряд: [uint16_t размер][строки RLE].
+		ENCODING_DELTA = 2,			// [uint32_t смещения ключевых кадров][кадры подряд: uint16_t размер, uint8_t delta_t, данные].
+		ENCODING_PAL4 = 3,			// Индексы палитры по 4 бита, старшая тетрада - левый пиксель, строка дополняется до байта.
+		ENCODING_PAL8 = 4,			// Индексы палитры по 8 бит.
+	};
+
+	// Наибольший размер палитры: ENCODING_PAL4 - 16 цветов, ENCODING_PAL8 - 256.
+	static constexpr uint16_t PALETTE_MAX = 256;
+
+	/*
+		Строка RLE - последовательность серий, в сумме ровно width пикселей, серия не переходит на следующую строку.
+		Байт управления: старший бит 0 - (n + 1) прозрачных пикселей, старший бит 1 - (n + 1) пикселей
+		цвета rgba_t, который идёт следом. n - младшие 7 бит.
+	*/
+	static constexpr uint8_t RLE_COLOR = 0x80;
+	static constexpr uint8_t RLE_MAX_RUN = 128;
+
+	/*
+		Кадры ENCODING_DELTA. Ключевой кадр - строки RLE, остальные - список изменённых участков
+		относительно предыдущего кадра: [x][y][count][rgba_t x count], участок не переходит на следующую строку.
+		Ключевым всегда является каждый key_interval-й кадр начиная с нулевого, их смещения в таблице key_table.
+	*/
+	enum delta_t : uint8_t
+	{
+		DELTA_KEYFRAME = 0,
+		DELTA_SPANS = 1,
+	};
+	static constexpr uint8_t DELTA_MAX_SPAN = 64;
+
+	/*
+		Порядок кадров. Кадры 0 .. loop_end проигрываются один раз, дальше:
+		PLAY_LOOP - повтор с loop_start по loop_end, PLAY_ONCE - остановка на loop_end,
+		PLAY_PINGPONG - вперёд и назад между loop_start и loop_end.
+	*/
+	enum play_mode_t : uint8_t
+	{
+		PLAY_LOOP = 0,
+		PLAY_ONCE = 1,
+		PLAY_PINGPONG = 2,
+	};
+
+	// Запись таблицы кадров, по одной на кадр.
+	struct __attribute__((__packed__)) frame_entry_t
+	{
+		uint32_t offset;			// Смещение кадра от начала файла (у RLE - его префикса размера).
+		uint16_t duration;			// Длительность кадра, мс; 0 - delay из заголовка.
+	};
+
+	struct __attribute__((__packed__)) layer_header_t
+	{
+		char magic[4];				// LAYER_MAGIC.
+		uint8_t version;			// LAYER_VERSION.
+		uint8_t flags;				// LAYER_FLAG_*.
+		uint16_t header_size;		// Размер заголовка, палитра или кадры начинаются сразу за ним.
+		uint8_t width;
+		uint8_t height;
+		uint16_t frames;
+		uint16_t delay;				// Интервал между кадрами, мс.
+		uint8_t encoding;			// encoding_t.
+		uint8_t mode;				// play_mode_t.
+		uint16_t key_interval;		// ENCODING_DELTA: интервал ключевых кадров.
+		uint32_t key_table;			// ENCODING_DELTA: смещение таблицы ключевых кадров.
+		uint16_t palette_count;		// ENCODING_PAL*: кол-во цветов палитры, она идёт сразу за заголовком.
+		uint16_t loop_start;
+		uint16_t loop_end;			// 0 - последний кадр.
+		uint32_t frame_table;		// Смещение таблицы frame_entry_t[frames], 0 - таблицы нет.
+		uint8_t x;					// Положение левого верхнего угла слоя на панели,
+		uint8_t y;					// слой меньше панели выводится только в своём прямоугольнике.
+	};
+
+
+	/*
+		Пакет изображений: все слои и пользовательские картинки в одном файле.
+		[pack_header_t][pack_entry_t x entry_count][файлы PXL2]
+		Индекс плотный: запись слоя N - PACK_LAYER + N, картинки userNNN - PACK_USER + NNN - 1.
+		Одинаковые изображения хранятся один раз, их записи указывают на одни данные.
+		Смещения внутри файла PXL2 отсчитываются от начала этого файла, а не пакета.
+	*/
+	static constexpr char PACK_MAGIC[4] = {'P', 'X', 'P', 'K'};
+	static constexpr uint8_t PACK_VERSION = 1;
+
+	static constexpr uint16_t PACK_LAYER = 0;
+	static constexpr uint16_t PACK_USER = 8;
+	static constexpr uint16_t PACK_ENTRIES = PACK_USER + 255;
+
+	struct __attribute__((__packed__)) pack_header_t
+	{
+		char magic[4];				// PACK_MAGIC.
+		uint8_t version;			// PACK_VERSION.
+		uint8_t reserved;
+		uint16_t entry_count;
+	};
+
+	struct __attribute__((__packed__)) pack_entry_t
+	{
+		uint32_t offset;			// Смещение файла PXL2 от начала пакета.
+		uint32_t size;				// 0 - изображения нет.
+		uint8_t encoding;			// encoding_t.
+		uint8_t width;
+		uint8_t height;
+		uint8_t reserved;
+	};
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string.h>
+#include <PxlFormat.h>
+#include <PxlFile.h>
+
+/*
+	Пакет изображений (Pxl::pack_header_t).
+	Файл открывается один раз при старте, картинка находится по номеру записи в индексе:
+	одно чтение записи вместо поиска файла в папке. Таблица кластеров пакета на _linkMapSize
+	элементов общая для всех открытых из него изображений.
+*/
+template <uint16_t _linkMapSize>
+class PxlPack
+{
+	public:
+
+		bool Open(const char *filename)
+		{
+			_file.Close();
+			if(_file.Open(filename) == false) return false;
+
+			if(_file.Read(0, &_header, sizeof(_header)) == false || memcmp(_header.magic, Pxl::PACK_MAGIC, sizeof(_header.magic)) != 0 || _header.version != Pxl::PACK_VERSION)
+			{
+				_file.Close();
+				return false;
+			}
+			_file.LinkMap(_linkMap, _linkMapSize);
+
+			return true;
+		}
+
+		bool IsOpen() const
+		{
+			return _file.IsOpen();
+		}
+
+		// false, если пакета нет или изображения с таким номером в нём нет.
+		bool GetEntry(uint16_t idx, Pxl::pack_entry_t &entry)
+		{
+			if(_file.IsOpen() == false || idx >= _header.entry_count) return false;
+			if(_file.Read(sizeof(_header) + idx * sizeof(entry), &entry, sizeof(entry)) == false) return false;
+
+			return (entry.size > 0);
+		}
+
+		// Файл пакета, из него изображение открывается как часть: PxlFile::Open(File(), entry.offset, entry.size).
+		const PxlFile &File() const
+		{
+			return _file;
+		}
+
+	private:
+
+		PxlFile _file;
+		Pxl::pack_header_t _header = {};
+		DWORD _linkMap[_linkMapSize];
+};
@@ -68,6 +68,40 @@ DWORD get_fattime (void);
 #define MMC_GET_OCR			13	/* Get OCR */
 #define MMC_GET_SDSTAT		14	/* Get SD status */
 
+/* Asynchronous read (not used by FatFs), buff: DISK_READ_ASYNC* */
+#define CTRL_READ_START		30	/* Start reading sectors and return at once */
+#define CTRL_READ_POLL		31	/* Advance the read in progress, if any */
+
+/* Asynchronous read request: busy is cleared and res is set when the read is complete */
+typedef struct {
+	BYTE *buff;				/* Data buffer to store read data */
+	DWORD sector;			/* Start sector in LBA */
+	UINT count;				/* Number of sectors to read */
+	volatile BYTE busy;
+	volatile DRESULT res;
+} DISK_READ_ASYNC;
+
+/* Sector cache (not used by FatFs) */
+#define CTRL_CACHE_LIMIT	32	/* buff: DWORD*, cache single sector reads below this sector */
+#define CTRL_CACHE_STATS	33	/* buff: DWORD[2], cache hits and misses */
+
+/* Card benchmark (not used by FatFs), buff: DISK_BENCHMARK* */
+#define CTRL_BENCHMARK		34	/* Measure the card, tune the driver and return the profile */
+#define CTRL_PROFILE		35	/* Return the last measured profile, RES_NOTRDY if there is none */
+
+/* Benchmark: count sectors from sector are read twice through buff, the results go to the rest */
+typedef struct {
+	BYTE *buff;				/* Sector buffer */
+	DWORD sector;			/* Start sector in LBA */
+	UINT count;				/* Number of sectors to read */
+	WORD init_time;			/* Card initialization, ms */
+	WORD latency;			/* Longest single block command to data token time, us */
+	WORD single_rate;		/* Single block reads, KB/s */
+	WORD multi_rate;		/* Multiple block reads, KB/s */
+	BYTE spi_divider;		/* SPI clock divider chosen */
+	BYTE read_ahead;		/* Read-ahead: 0 - off, else on with the build time depth, sectors */
+} DISK_BENCHMARK;
+
 /* ATA/CF specific ioctl command */
 #define ATA_GET_REV			20	/* Get F/W revision */
 #define ATA_GET_MODEL		21	/* Get model name */
@@ -37,7 +37,9 @@ CAN_HandleTypeDef hcan;
 SPI_HandleTypeDef hspi2;
 TIM_HandleTypeDef htim1;
 TIM_HandleTypeDef htim2;
-DMA_HandleTypeDef hdma_tim2_ch1;
+DMA_HandleTypeDef hdma_tim2_up;
+DMA_HandleTypeDef hdma_spi2_rx;
+DMA_HandleTypeDef hdma_spi2_tx;
 UART_HandleTypeDef hDebugUart;
 
 volatile uint16_t Timer1 = 0;
@@ -124,6 +126,24 @@ void InitFlash()
 		
 		Logger.PrintTopic("SD").Printf("Init error, code: %d", mount_res).PrintNewLine();
 	}
+	else
+	{
+		// Кэш секторов драйвера - для FAT и корневого каталога FAT12/16, до области данных.
+		disk_ioctl(SDFatFs.drv, CTRL_CACHE_LIMIT, &SDFatFs.database);
+
+		// Замеры карты по первым секторам области данных через окно FatFs: задержка и скорость чтения,
+		// подбор частоты SPI и включение упреждающего чтения. Результат - в логе и в BlockHealth.
+		DISK_BENCHMARK bench = {SDFatFs.win.d8, SDFatFs.database, 16};
+		if(disk_ioctl(SDFatFs.drv, CTRL_BENCHMARK, &bench) == RES_OK)
+		{
+			Logger.PrintTopic("SD").Printf("Init %d ms, latency %d us, CMD17 %d KB/s, CMD18 %d KB/s, SPI /%d, read-ahead %s", bench.init_time, bench.latency, bench.single_rate, bench.multi_rate, bench.spi_divider, (bench.read_ahead ? "on" : "off")).PrintNewLine();
+		}
+		else
+		{
+			Logger.PrintTopic("SD").Printf("Benchmark error").PrintNewLine();
+		}
+		SDFatFs.winsect = 0xFFFFFFFF;
+	}
     /*
     else
     {
@@ -259,6 +279,8 @@ DEBUG_LOG_TOPIC("aaa", "last_clust: %ld, free_clust: %ld, csize: %ld, fsize: %ld
         CANLib::Loop(current_time);
         Matrix::Loop(current_time);
         Outputs::Loop(current_time);
+        // Упреждающее чтение карты и закрытие потока в простое.
+        disk_ioctl(SDFatFs.drv, CTRL_READ_POLL, nullptr);
     }
 }
 
@@ -516,9 +538,10 @@ static void MX_DMA_Init(void)
     __HAL_RCC_DMA1_CLK_ENABLE();
 
     // DMA interrupt init
-    // DMA1_Channel5_IRQn interrupt configuration
-    HAL_NVIC_SetPriority(DMA1_Channel5_IRQn, 0, 0);
-    HAL_NVIC_EnableIRQ(DMA1_Channel5_IRQn);
+    // DMA1_Channel2_IRQn interrupt configuration (TIM2_UP, светодиоды).
+    // Каналы 4 и 5 (SPI2_RX, SPI2_TX) карта опрашивает сама, без прерываний.
+    HAL_NVIC_SetPriority(DMA1_Channel2_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel2_IRQn);
 }
 
 /**
@@ -27,7 +27,7 @@ SPI_HandleTypeDef *hspi_obj = &hspi2;
 
 
 
-
+#ifndef SD_HOST
 void HAL_SPI_ReadFast(uint8_t *pRxData, uint16_t Size, uint32_t Timeout)
 {
 	SPI_TypeDef *SPIx= hspi_obj->Instance;
@@ -106,9 +106,53 @@ void HAL_SPI_WriteReadFast(uint8_t *pTxData, uint8_t *pRxData, uint16_t Size, ui
 	
 	return;
 }
+// Приём Size байт через DMA: SPI2_RX (DMA1 Channel4) пишет в pRxData, SPI2_TX (Channel5) передаёт 0xFF.
+// Возвращает управление сразу, процессор свободен до HAL_SPI_ReadDMA_Wait().
+void HAL_SPI_ReadDMA(uint8_t *pRxData, uint16_t Size)
+{
+	static const uint8_t TXdummy = 0xFF;
+	SPI_TypeDef *SPIx= hspi_obj->Instance;
+	
+	__HAL_SPI_ENABLE(hspi_obj);
+	HAL_DMA_Start(hspi_obj->hdmarx, (uint32_t)&SPIx->DR, (uint32_t)pRxData, Size);
+	HAL_DMA_Start(hspi_obj->hdmatx, (uint32_t)&TXdummy, (uint32_t)&SPIx->DR, Size);
+	
+	// RX включается первым, чтобы не пропустить байт, принятый в ответ на первую передачу.
+	SET_BIT(SPIx->CR2, SPI_CR2_RXDMAEN);
+	SET_BIT(SPIx->CR2, SPI_CR2_TXDMAEN);
+	
+	return;
+}
 
+uint8_t HAL_SPI_ReadDMA_IsBusy(void)
+{
+	return (__HAL_DMA_GET_COUNTER(hspi_obj->hdmarx) != 0) ? 1 : 0;
+}
 
-
+// Ожидание окончания HAL_SPI_ReadDMA(): 0 - данные приняты, 1 - таймаут, передача остановлена.
+uint8_t HAL_SPI_ReadDMA_Wait(uint32_t Timeout)
+{
+	SPI_TypeDef *SPIx= hspi_obj->Instance;
+	uint8_t result = 0;
+	
+	if( HAL_DMA_PollForTransfer(hspi_obj->hdmarx, HAL_DMA_FULL_TRANSFER, Timeout) != HAL_OK ) result = 1;
+	if( HAL_DMA_PollForTransfer(hspi_obj->hdmatx, HAL_DMA_FULL_TRANSFER, Timeout) != HAL_OK ) result = 1;
+	
+	CLEAR_BIT(SPIx->CR2, SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN);
+	if(result != 0)
+	{
+		HAL_DMA_Abort(hspi_obj->hdmarx);
+		HAL_DMA_Abort(hspi_obj->hdmatx);
+	}
+	
+	return result;
+}
+#else
+// Сборка на ПК (tools/sdemu): обмен по SPI и DMA даёт модель карты.
+void HAL_SPI_ReadFast(uint8_t *pRxData, uint16_t Size, uint32_t Timeout);
+void HAL_SPI_WriteFast(uint8_t *pTxData, uint16_t Size, uint32_t Timeout);
+void HAL_SPI_WriteReadFast(uint8_t *pTxData, uint8_t *pRxData, uint16_t Size, uint32_t Timeout);
+#endif
 
 
 
@@ -183,6 +227,9 @@ uint8_t SD_cmd(uint8_t cmd, uint32_t arg)
 	rxtxbuff[5] = cnt;
 	HAL_SPI_WriteFast(rxtxbuff, 6, 1000);
 	
+	// После CMD12 карта выдаёт ещё один байт данных (stuff byte), пропускаем его.
+	if(cmd == CMD12) HAL_SPI_ReadFast(rxtxbuff, 1, 100);
+	
 	// Ждём ответ R1, в котором старший бит всегда 0. На шине до этого 0xFF
 	cnt = 10;
 	do {
@@ -206,38 +253,436 @@ void SD_PowerOn(void)
 // https://www.st.com/resource/en/application_note/an5595-spc58xexspc58xgx-multimedia-card-via-spi-interface-stmicroelectronics.pdf
 // http://www.edproject.co.uk/18Series14.html
 
-uint8_t SD_Read_Block(uint8_t *buff, uint32_t lba)
+/*
+	Асинхронное чтение: SD_Read_Submit() ставит запрос и сразу возвращает управление,
+	SD_Read_Poll() продвигает чтение на шаг - пока карта готовит блок (ожидание токена)
+	или блок принимается по DMA, цикл программы продолжает работу.
+	Чтение идёт потоком CMD18 (READ_MULTIPLE_BLOCK), который после запроса остаётся открытым:
+	запрос следующих по порядку блоков продолжает поток без новой команды, а пока запросов нет,
+	SD_Read_Poll() принимает следующий блок в буфер упреждающего чтения. Поток закрывается (CMD12)
+	при запросе не по порядку, простое дольше SD_STREAM_IDLE или перед другой командой (SD_Read_Stop()).
+	Одновременно идёт один запрос; синхронные чтения сначала дожидаются его окончания.
+*/
+#define SD_READ_TIMEOUT		100		// Ожидание токена или окончания передачи, мс.
+#define SD_READ_TOKEN_POLL	16		// Байт ожидания токена за один вызов SD_Read_Poll().
+#define SD_STREAM_IDLE		20		// Простой открытого потока до закрытия, мс.
+#ifndef SD_READ_AHEAD
+#define SD_READ_AHEAD		1		// Блоков упреждающего чтения, 0 - только держать поток открытым.
+#endif
+#define SD_BENCH_SLOWEST	SPI_BAUDRATEPRESCALER_16	// Самая низкая частота SPI, которую пробует SD_Benchmark().
+
+// Упреждающее чтение до замеров - SD_READ_AHEAD, затем по профилю карты.
+sd_profile_t sdprofile = { .read_ahead = SD_READ_AHEAD };
+
+enum { SD_STEP_IDLE, SD_STEP_TOKEN, SD_STEP_DATA, SD_STEP_STOP };
+
+static struct
+{
+	uint8_t *buff;				// Запрос: куда, с какого адреса и сколько блоков осталось.
+	uint32_t lba;
+	uint32_t count;
+	sd_callback_t callback;
+	void *context;
+	uint8_t active;
+	sd_async_t result;
+	
+	uint8_t step;
+	uint8_t *target;			// Куда принимается текущий блок: буфер запроса или _ahead.
+	uint32_t time;				// Начало текущего шага, для таймаута, или последнего чтения.
+	uint8_t stream;				// Поток CMD18 открыт.
+	uint32_t next;				// Адрес блока, который карта передаст следующим.
+#if SD_READ_AHEAD > 0
+	uint32_t ahead_lba;
+	uint8_t ahead_count;
+	uint8_t ahead_first;
+	uint8_t ahead[SD_READ_AHEAD][512];
+#endif
+} sd_read = {0};
+
+// Шаг адреса на блок: у SDHC/SDXC адрес - номер блока, у остальных - в байтах.
+static uint32_t SD_Block_Step(void)
+{
+	return (sdinfo.type & CT_BLOCK) ? 1 : 512;
+}
+
+static sd_async_t SD_Read_Finish(sd_async_t result)
+{
+	sd_read.active = 0;
+	sd_read.result = result;
+	sd_read.time = HAL_GetTick();
+	
+	if(sd_read.callback != NULL) sd_read.callback(result, sd_read.context);
+	
+	return result;
+}
+
+// Остановить поток: CMD12 (STOP_TRANSMISSION), затем карта держит линию в 0, пока занята.
+static void SD_Stream_Close(void)
+{
+	SD_cmd(CMD12, 0x00000000);
+	sd_read.time = HAL_GetTick();
+	sd_read.step = SD_STEP_STOP;
+	
+	return;
+}
+
+// Ошибка потока: состояние карты неизвестно, поток закрывается, буфер упреждающего чтения сбрасывается.
+static sd_async_t SD_Stream_Error(void)
 {
-	static const uint16_t block_size = 512U;
 	uint8_t result;
+	
+#if SD_READ_AHEAD > 0
+	sd_read.ahead_count = 0;
+#endif
+	SD_Stream_Close();
+	SPI_wait_ready(0xFF, &result);
+	sd_read.step = SD_STEP_IDLE;
+	sd_read.stream = 0;
+	SPI_Release();
+	
+#if SD_READ_AHEAD > 0
+	// Ошибка на блоке упреждающего чтения - не ошибка запроса: он начнёт новый поток.
+	if(sd_read.active == 1 && sd_read.target != sd_read.buff) return SD_ASYNC_BUSY;
+#endif
+	if(sd_read.active == 1) return SD_Read_Finish(SD_ASYNC_ERROR);
+	return sd_read.result;
+}
+
+uint8_t SD_Read_Submit(uint8_t *buff, uint32_t lba, uint32_t count, sd_callback_t callback, void *context)
+{
+	if(sd_read.active == 1 || count == 0) return 1;
+	
+	sd_read.buff = buff;
+	sd_read.lba = lba;
+	sd_read.count = count;
+	sd_read.callback = callback;
+	sd_read.context = context;
+	sd_read.result = SD_ASYNC_BUSY;
+	sd_read.active = 1;
+	
+	return 0;
+}
+
+sd_async_t SD_Read_Poll(void)
+{
+	static const uint16_t block_size = 512U;
+	uint8_t result = 0xFF;
 	uint8_t rxtxbuff[2];
 	
-	// Отправляем команду CMD17 (READ_SINGLE_BLOCK)
-	result = SD_cmd(CMD17, lba);
-	if(result != 0x00) return 5;
+	while(1)
+	{
+		switch(sd_read.step)
+		{
+			case SD_STEP_IDLE:
+			{
+				if(sd_read.active == 0)
+				{
+#if SD_READ_AHEAD > 0
+					// Запросов нет: принимаем следующий блок потока заранее.
+					if(sd_read.stream == 1 && sd_read.ahead_count < sdprofile.read_ahead)
+					{
+						if(sd_read.ahead_count == 0)
+						{
+							sd_read.ahead_lba = sd_read.next;
+							sd_read.ahead_first = 0;
+						}
+						sd_read.target = sd_read.ahead[(sd_read.ahead_first + sd_read.ahead_count) % SD_READ_AHEAD];
+						sd_read.time = HAL_GetTick();
+						sd_read.step = SD_STEP_TOKEN;
+						return sd_read.result;
+					}
+#endif
+					if(sd_read.stream == 1 && HAL_GetTick() - sd_read.time >= SD_STREAM_IDLE) SD_Stream_Close();
+					return sd_read.result;
+				}
+				
+#if SD_READ_AHEAD > 0
+				// Блок уже принят заранее.
+				if(sd_read.ahead_count > 0 && sd_read.ahead_lba == sd_read.lba)
+				{
+					memcpy(sd_read.buff, sd_read.ahead[sd_read.ahead_first], block_size);
+					sd_read.ahead_first = (sd_read.ahead_first + 1) % SD_READ_AHEAD;
+					sd_read.ahead_lba += SD_Block_Step();
+					sd_read.ahead_count--;
+					
+					sd_read.buff += block_size;
+					sd_read.lba += SD_Block_Step();
+					if(--sd_read.count == 0) return SD_Read_Finish(SD_ASYNC_OK);
+					continue;
+				}
+				if(sd_read.ahead_count > 0 && sd_read.stream == 1)
+				{
+					// Запрос не по порядку: подчитанное не нужно, поток закрывается.
+					sd_read.ahead_count = 0;
+					SD_Stream_Close();
+					continue;
+				}
+				sd_read.ahead_count = 0;
+#endif
+				if(sd_read.stream == 1 && sd_read.next == sd_read.lba)
+				{
+					sd_read.target = sd_read.buff;
+					sd_read.time = HAL_GetTick();
+					sd_read.step = SD_STEP_TOKEN;
+					continue;
+				}
+				if(sd_read.stream == 1)
+				{
+					SD_Stream_Close();
+					continue;
+				}
+				
+				result = SD_cmd(CMD18, sd_read.lba);
+				if(result != 0x00)
+				{
+					SPI_Release();
+					return SD_Read_Finish(SD_ASYNC_ERROR);
+				}
+				
+				// Непонимаю зачем это тут, но это уменьшает время ожидания данных на ~1мс.
+				HAL_SPI_ReadFast(&result, 1, 100);
+				
+				sd_read.stream = 1;
+				sd_read.next = sd_read.lba;
+				sd_read.target = sd_read.buff;
+				sd_read.time = HAL_GetTick();
+				sd_read.step = SD_STEP_TOKEN;
+				
+				return SD_ASYNC_BUSY;
+			}
+			case SD_STEP_TOKEN:
+			{
+				// Ждём токен начала данных, но не дольше SD_READ_TOKEN_POLL байт за вызов.
+				for(uint8_t cnt = 0; cnt < SD_READ_TOKEN_POLL && result == 0xFF; ++cnt)
+				{
+					HAL_SPI_ReadFast(&result, 1, 100);
+				}
+				// Data error token (0000xxxx): блок не будет передан, ждать таймаут незачем.
+				if(result != 0xFF && result != 0xFE) return SD_Stream_Error();
+				if(result != 0xFE)
+				{
+					if(HAL_GetTick() - sd_read.time >= SD_READ_TIMEOUT) return SD_Stream_Error();
+					return (sd_read.active == 1) ? SD_ASYNC_BUSY : sd_read.result;
+				}
+				
+				// 512 байт принимает DMA.
+				HAL_SPI_ReadDMA(sd_read.target, block_size);
+				sd_read.time = HAL_GetTick();
+				sd_read.step = SD_STEP_DATA;
+				
+				return (sd_read.active == 1) ? SD_ASYNC_BUSY : sd_read.result;
+			}
+			case SD_STEP_DATA:
+			{
+				if(HAL_SPI_ReadDMA_IsBusy() == 1 && HAL_GetTick() - sd_read.time < SD_READ_TIMEOUT)
+				{
+					return (sd_read.active == 1) ? SD_ASYNC_BUSY : sd_read.result;
+				}
+				if(HAL_SPI_ReadDMA_Wait(0) != 0) return SD_Stream_Error();
+				
+				// Читаем 2 байта CRC
+				HAL_SPI_ReadFast(rxtxbuff, 2, 100);
+				
+				sd_read.next += SD_Block_Step();
+				sd_read.time = HAL_GetTick();
+				sd_read.step = SD_STEP_IDLE;
+				
+#if SD_READ_AHEAD > 0
+				if(sd_read.target != sd_read.buff)
+				{
+					sd_read.ahead_count++;
+					continue;
+				}
+#endif
+				sd_read.buff += block_size;
+				sd_read.lba += SD_Block_Step();
+				if(--sd_read.count == 0) return SD_Read_Finish(SD_ASYNC_OK);
+				
+				continue;
+			}
+			case SD_STEP_STOP:
+			{
+				HAL_SPI_ReadFast(&result, 1, 100);
+				if(result != 0xFF && HAL_GetTick() - sd_read.time < SD_READ_TIMEOUT)
+				{
+					return (sd_read.active == 1) ? SD_ASYNC_BUSY : sd_read.result;
+				}
+				
+				sd_read.stream = 0;
+				sd_read.step = SD_STEP_IDLE;
+				SPI_Release();
+				
+				if(sd_read.active == 0) return sd_read.result;
+				continue;
+			}
+			default:
+			{
+				return sd_read.result;
+			}
+		}
+	}
+}
+
+// Дождаться окончания текущего асинхронного запроса. Поток при этом остаётся открытым.
+sd_async_t SD_Read_Wait(void)
+{
+	sd_async_t result;
+	
+	do
+	{
+		result = SD_Read_Poll();
+	} while(sd_read.active == 1);
 	
-	// Непонимаю зачем это тут, но это уменьшает время ожидания данных на ~1мс.
-	HAL_SPI_ReadFast(rxtxbuff, 1, 100);
+	return result;
+}
+
+// Дождаться окончания запроса и закрыть поток: перед любой другой командой карте.
+void SD_Read_Stop(void)
+{
+	SD_Read_Wait();
+	while(sd_read.step != SD_STEP_IDLE)
+	{
+		SD_Read_Poll();
+	}
+	if(sd_read.stream == 1)
+	{
+		SD_Stream_Close();
+		while(sd_read.step != SD_STEP_IDLE)
+		{
+			SD_Read_Poll();
+		}
+	}
 	
-	// Ждём токен начала данных
-	if( SPI_wait_ready(0xFE, &result) == 0 ) return 5;
+	return;
+}
 
-	// Читаем 512 байт
-	HAL_SPI_ReadFast(buff, block_size, 1000);
+uint8_t SD_Read_Block(uint8_t *buff, uint32_t lba)
+{
+	return SD_Read_Blocks(buff, lba, 1);
+}
 
-	// Читаем 2 байта CRC
-	HAL_SPI_ReadFast(rxtxbuff, 2, 100);
+// Чтение count блоков подряд одной командой CMD18 или из уже открытого потока.
+uint8_t SD_Read_Blocks(uint8_t *buff, uint32_t lba, uint32_t count)
+{
+	SD_Read_Wait();
+	if(SD_Read_Submit(buff, lba, count, NULL, NULL) != 0) return 5;
+	
+	return (SD_Read_Wait() == SD_ASYNC_OK) ? 0 : 5;
+}
 
-	// Если используем CMD18 (READ_MULTIPLE_BLOCK), то останавливаем передачу.
-	//SD_cmd(CMD12, 0x00000000);
+/*
+	Замеры карты для профиля sdprofile: время от команды до токена данных, скорость чтения по блоку (CMD17)
+	и потоком (CMD18, как читает SD_Read_Poll()). Блоки читаются по очереди в buff, контрольные суммы
+	обоих проходов должны совпасть - иначе частота SPI снижается вдвое, до SD_BENCH_SLOWEST.
+	Упреждающее чтение включается, только если поток быстрее чтения по блоку.
+	Время считается по счётчику тактов ядра (DWT). 0 - профиль заполнен, 1 - карта не читается.
+*/
+static uint32_t SD_Bench_Sum(uint32_t sum, const uint8_t *buff)
+{
+	for(uint16_t i = 0; i < 512; ++i)
+	{
+		sum = (sum << 1 | sum >> 31) ^ buff[i];
+	}
+	
+	return sum;
+}
 
+// Чтение блока командой CMD17, latency - тактов от команды до токена данных.
+static uint8_t SD_Bench_Single(uint8_t *buff, uint32_t lba, uint32_t *latency)
+{
+	uint32_t start = DWT->CYCCNT;
+	uint8_t result;
+	uint8_t rxtxbuff[2];
+	
+	if(SD_cmd(CMD17, lba) != 0x00 || SPI_wait_ready(0xFE, &result) == 0)
+	{
+		SPI_Release();
+		return 1;
+	}
+	*latency = DWT->CYCCNT - start;
+	
+	HAL_SPI_ReadDMA(buff, 512);
+	result = HAL_SPI_ReadDMA_Wait(SD_READ_TIMEOUT);
+	HAL_SPI_ReadFast(rxtxbuff, 2, 100);
+	SPI_Release();
+	
+	return result;
+}
+
+static uint8_t SD_Bench_Pass(uint8_t *buff, uint32_t lba, uint32_t count)
+{
+	uint32_t cycles_us = SystemCoreClock / 1000000U;
+	uint32_t latency, worst = 0;
+	uint32_t single_sum = 0, multi_sum = 0;
+	uint32_t single, multi;
+	uint32_t start;
+	
+	start = DWT->CYCCNT;
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		if(SD_Bench_Single(buff, lba + i * SD_Block_Step(), &latency) != 0) return 1;
+		if(latency > worst) worst = latency;
+		single_sum = SD_Bench_Sum(single_sum, buff);
+	}
+	single = (DWT->CYCCNT - start) / cycles_us;
+	
+	start = DWT->CYCCNT;
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		if(SD_Read_Blocks(buff, lba + i * SD_Block_Step(), 1) != 0) return 1;
+		multi_sum = SD_Bench_Sum(multi_sum, buff);
+	}
+	SD_Read_Stop();
+	multi = (DWT->CYCCNT - start) / cycles_us;
+	
+	if(single_sum != multi_sum) return 1;
+	
+	// 512 байт за N мкс = 500000 / N КБ/с.
+	sdprofile.latency = worst / cycles_us;
+	sdprofile.single_rate = (count * 500000U) / (single + 1);
+	sdprofile.multi_rate = (count * 500000U) / (multi + 1);
+	sdprofile.spi_divider = 2 << (hspi_obj->Init.BaudRatePrescaler / SPI_BAUDRATEPRESCALER_4);
+	sdprofile.read_ahead = (sdprofile.multi_rate > sdprofile.single_rate) ? SD_READ_AHEAD : 0;
+	sdprofile.measured = 1;
+	
 	return 0;
 }
 
+uint8_t SD_Benchmark(uint8_t *buff, uint32_t lba, uint32_t count)
+{
+	uint32_t temp = hspi_obj->Init.BaudRatePrescaler;
+	
+	sdprofile.measured = 0;
+	if(count == 0) return 1;
+	
+	SD_Read_Stop();
+#if SD_READ_AHEAD > 0
+	sd_read.ahead_count = 0;
+#endif
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	
+	for(uint32_t prescaler = temp; prescaler <= SD_BENCH_SLOWEST; prescaler += SPI_BAUDRATEPRESCALER_4)
+	{
+		hspi_obj->Init.BaudRatePrescaler = prescaler;
+		HAL_SPI_Init(hspi_obj);
+		if(SD_Bench_Pass(buff, lba, count) == 0) return 0;
+	}
+	
+	hspi_obj->Init.BaudRatePrescaler = temp;
+	HAL_SPI_Init(hspi_obj);
+	
+	return 1;
+}
+
 uint8_t SD_Write_Block (uint8_t *buff, uint32_t lba)
 {
   uint8_t result;
   uint16_t cnt;
+  SD_Read_Stop();
+#if SD_READ_AHEAD > 0
+  sd_read.ahead_count = 0;
+#endif
   result=SD_cmd(CMD24,lba); //CMD24 ������� ��� 51 � 97-98
   if (result!=0x00) return 6; //�����, ���� ��������� �� 0x00
   SPI_Release();
@@ -262,6 +707,8 @@ uint8_t sd_ini(void)
   int16_t tmr;
   uint32_t temp;
 
+  uint32_t start = HAL_GetTick();
+
   sdinfo.type = 0;
 	uint8_t ocr[4];
 	temp = hspi_obj->Init.BaudRatePrescaler;
@@ -313,6 +760,7 @@ uint8_t sd_ini(void)
   {
     return 1;
   }
+  sdprofile.init_time = HAL_GetTick() - start;
   //sprintf(str1,"Type SD: 0x%02X\r\n",sdinfo.type);
   //HAL_UART_Transmit(&huart1,(uint8_t*)str1,strlen(str1),0x1000);	
   return 0;
@@ -22,6 +22,26 @@
 #define CT_SDC (CT_SD1|CT_SD2) /* SD */
 #define CT_BLOCK 0x08 /* Block addressing */
 //--------------------------------------------------
+// Результат асинхронного чтения.
+typedef enum {
+  SD_ASYNC_IDLE = 0,	// Чтений ещё не было.
+  SD_ASYNC_BUSY,		// Чтение идёт.
+  SD_ASYNC_OK,
+  SD_ASYNC_ERROR
+} sd_async_t;
+typedef void (*sd_callback_t)(sd_async_t result, void *context);
+//--------------------------------------------------
+// Профиль карты по замерам SD_Benchmark().
+typedef struct {
+  uint16_t init_time;	// sd_ini(), мс.
+  uint16_t latency;		// Наибольшее время от команды CMD17 до токена данных, мкс.
+  uint16_t single_rate;	// Чтение по блоку (CMD17), КБ/с.
+  uint16_t multi_rate;	// Чтение потоком (CMD18), КБ/с.
+  uint8_t spi_divider;	// Делитель частоты SPI, на котором данные читаются стабильно.
+  uint8_t read_ahead;	// Упреждающее чтение: 0 - выключено, SD_READ_AHEAD - включено. Глубина задаётся при сборке.
+  uint8_t measured;		// Замеры прошли успешно, поля выше - по ним.
+} sd_profile_t;
+//--------------------------------------------------
 typedef struct sd_info {
   volatile uint8_t type;//��� �����
 } sd_info_ptr;
@@ -30,7 +50,16 @@ void SD_PowerOn(void);
 uint8_t sd_ini(void);
 void SPI_Release(void);
 uint8_t SD_Read_Block (uint8_t *buff, uint32_t lba);
+uint8_t SD_Read_Blocks(uint8_t *buff, uint32_t lba, uint32_t count);
+uint8_t SD_Read_Submit(uint8_t *buff, uint32_t lba, uint32_t count, sd_callback_t callback, void *context);
+sd_async_t SD_Read_Poll(void);
+sd_async_t SD_Read_Wait(void);
+void SD_Read_Stop(void);
+uint8_t SD_Benchmark(uint8_t *buff, uint32_t lba, uint32_t count);
 uint8_t SD_Write_Block (uint8_t *buff, uint32_t lba);
 uint8_t SPI_wait_ready(uint8_t neq, uint8_t *result);
+void HAL_SPI_ReadDMA(uint8_t *pRxData, uint16_t Size);
+uint8_t HAL_SPI_ReadDMA_IsBusy(void);
+uint8_t HAL_SPI_ReadDMA_Wait(uint32_t Timeout);
 //--------------------------------------------------
 #endif /* SD_H_ */
@@ -56,7 +56,7 @@ void SVC_Handler(void);
 void DebugMon_Handler(void);
 void PendSV_Handler(void);
 void SysTick_Handler(void);
-void DMA1_Channel5_IRQHandler(void);
+void DMA1_Channel2_IRQHandler(void);
 void USB_LP_CAN1_RX0_IRQHandler(void);
 void CAN1_SCE_IRQHandler(void);
 void TIM1_UP_IRQHandler(void);
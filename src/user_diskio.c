@@ -39,13 +39,61 @@
 #include "sd.h"
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
+/* Кэш секторов FAT и каталогов, секторов по 512 байт, 0 - без кэша */
+#ifndef USER_CACHE_SECTORS
+#define USER_CACHE_SECTORS 1
+#endif
 //extern UART_HandleTypeDef huart1;
 extern char str1[60];
 extern sd_info_ptr sdinfo;
+extern sd_profile_t sdprofile;
 /* Private variables ---------------------------------------------------------*/
 /* Disk status */
 static volatile DSTATUS Stat = STA_NOINIT;
 
+/*
+	Кэш секторов LRU по номеру сектора. Карта только читается (_FS_READONLY), поэтому
+	данные в кэше не устаревают. Кэшируются одиночные чтения секторов ниже CacheLimit
+	(CTRL_CACHE_LIMIT, обычно начало области данных: FAT и корневой каталог FAT12/16),
+	чтобы чтения данных файлов через окно FatFs их не вытесняли.
+*/
+static DWORD CacheLimit = 0;
+static DWORD CacheHits = 0;
+static DWORD CacheMisses = 0;
+#if USER_CACHE_SECTORS > 0
+static BYTE CacheData[USER_CACHE_SECTORS][512];
+static DWORD CacheSector[USER_CACHE_SECTORS];
+static DWORD CacheUsed[USER_CACHE_SECTORS];		/* 0 - пустая запись */
+static DWORD CacheClock = 0;
+
+static int USER_cache_find(DWORD sector)
+{
+		for (int i = 0; i < USER_CACHE_SECTORS; i++)
+		{
+			if (CacheUsed[i] != 0 && CacheSector[i] == sector) return i;
+		}
+		return -1;
+}
+
+static int USER_cache_victim(void)
+{
+		int victim = 0;
+		for (int i = 1; i < USER_CACHE_SECTORS; i++)
+		{
+			if (CacheUsed[i] < CacheUsed[victim]) victim = i;
+		}
+		return victim;
+}
+#endif
+
+/* Окончание асинхронного чтения CTRL_READ_START */
+static void USER_read_done(sd_async_t result, void *context)
+{
+		DISK_READ_ASYNC *read = (DISK_READ_ASYNC *)context;
+		read->res = (result == SD_ASYNC_OK) ? RES_OK : RES_ERROR;
+		read->busy = 0;
+}
+
 /* USER CODE END DECL */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -128,16 +176,41 @@ DRESULT USER_read (
 //		HAL_UART_Transmit(&huart1,(uint8_t*)str1,strlen(str1),0x1000);
 		if (pdrv || !count) return RES_PARERR;
 		if (Stat & STA_NOINIT) return RES_NOTRDY;
-		if (!(sdinfo.type & 4)) sector *= 512; /* Convert to byte address if needed */
+#if USER_CACHE_SECTORS > 0
+		int slot = -1;
+		if (count == 1 && sector < CacheLimit)
+		{
+			slot = USER_cache_find(sector);
+			if (slot >= 0)
+			{
+				CacheHits++;
+				CacheUsed[slot] = ++CacheClock;
+				memcpy(buff, CacheData[slot], 512);
+				return RES_OK;
+			}
+			CacheMisses++;
+			slot = USER_cache_victim();
+			CacheUsed[slot] = 0;
+		}
+		DWORD lba = sector;
+#endif
+		if (!(sdinfo.type & CT_BLOCK)) sector *= 512; /* Convert to byte address if needed */
 		if (count == 1) /* Single block read */
 		{
-			SD_Read_Block(buff,sector); //������� ���� � �����
-			count = 0;
+			if (SD_Read_Block(buff,sector) == 0) count = 0; //������� ���� � �����
+#if USER_CACHE_SECTORS > 0
+			if (slot >= 0 && count == 0)
+			{
+				memcpy(CacheData[slot], buff, 512);
+				CacheSector[slot] = lba;
+				CacheUsed[slot] = ++CacheClock;
+			}
+#endif
 		}
 		else /* Multiple block read */
 		{
+			if (SD_Read_Blocks(buff,sector,count) == 0) count = 0;
 		}
-		SPI_Release();
 		return count ? RES_ERROR : RES_OK;
     return RES_OK;
   /* USER CODE END READ */
@@ -167,7 +240,7 @@ DRESULT USER_write (
 	  if (pdrv || !count) return RES_PARERR;
 		if (Stat & STA_NOINIT) return RES_NOTRDY;
 		if (Stat & STA_PROTECT) return RES_WRPRT;
-		if (!(sdinfo.type & 4)) sector *= 512; /* Convert to byte address if needed */
+		if (!(sdinfo.type & CT_BLOCK)) sector *= 512; /* Convert to byte address if needed */
 		if (count == 1) /* Single block read */
 		{
 			SD_Write_Block((BYTE*)buff,sector); //������� ���� � �����
@@ -203,6 +276,55 @@ DRESULT USER_ioctl (
 //		HAL_UART_Transmit(&huart1,(uint8_t*)str1,strlen(str1),0x1000);
 		if (pdrv) return RES_PARERR;
 		if (Stat & STA_NOINIT) return RES_NOTRDY;
+		/* Асинхронное чтение: карту отпускает сам драйвер по окончании чтения */
+		if (cmd == CTRL_READ_START)
+		{
+			DISK_READ_ASYNC *read = (DISK_READ_ASYNC *)buff;
+			DWORD sector = read->sector;
+			if (!read->count) return RES_PARERR;
+			if (!(sdinfo.type & CT_BLOCK)) sector *= 512; /* Convert to byte address if needed */
+			SD_Read_Wait();
+			read->busy = 1;
+			read->res = RES_ERROR;
+			if (SD_Read_Submit(read->buff,sector,read->count,USER_read_done,read) != 0)
+			{
+				read->busy = 0;
+				return RES_ERROR;
+			}
+			return RES_OK;
+		}
+		if (cmd == CTRL_READ_POLL)
+		{
+			SD_Read_Poll();
+			return RES_OK;
+		}
+		if (cmd == CTRL_CACHE_LIMIT)
+		{
+			CacheLimit = *(DWORD *)buff;
+			return RES_OK;
+		}
+		if (cmd == CTRL_CACHE_STATS)
+		{
+			((DWORD *)buff)[0] = CacheHits;
+			((DWORD *)buff)[1] = CacheMisses;
+			return RES_OK;
+		}
+		if (cmd == CTRL_BENCHMARK || cmd == CTRL_PROFILE)
+		{
+			DISK_BENCHMARK *bench = (DISK_BENCHMARK *)buff;
+			DWORD sector = bench->sector;
+			if (!(sdinfo.type & CT_BLOCK)) sector *= 512; /* Convert to byte address if needed */
+			if (cmd == CTRL_BENCHMARK && SD_Benchmark(bench->buff,sector,bench->count) != 0) return RES_ERROR;
+			if (!sdprofile.measured) return RES_NOTRDY; /* No benchmark yet or it failed */
+			bench->init_time = sdprofile.init_time;
+			bench->latency = sdprofile.latency;
+			bench->single_rate = sdprofile.single_rate;
+			bench->multi_rate = sdprofile.multi_rate;
+			bench->spi_divider = sdprofile.spi_divider;
+			bench->read_ahead = sdprofile.read_ahead;
+			return RES_OK;
+		}
+		SD_Read_Stop();
 		res = RES_ERROR;
 		switch (cmd)
 		{
@@ -0,0 +1,134 @@
+# Изображения во внутренней flash: include/PxlFlashData.h с constexpr-массивами лежит в репозитории,
+# поэтому обычная сборка не требует ничего, кроме PlatformIO. Скрипт пересобирает этот файл из
+# файлов layerN.pxl и userNNN.pxl папки flash, только когда его об этом просят:
+#   PlatformIO extra_script (pre:) - если в platformio.ini задан custom_flash_images = <папка>;
+#   без PlatformIO - python3 tools/flash_images.py <папка> <папка для PxlFlashData.h> [бюджет],
+#   пустая строка вместо папки - прошивка без изображений во flash.
+# PXL из редактора перекодирует в PXL2 RLE pxltool convert rle, для этого нужны cmake и компилятор
+# C++: pxltool собирается из tools/pxltool. PXL2 (например, после pxltool optimize) берётся как есть.
+# Сумма размеров не должна превышать custom_flash_budget байт (по умолчанию 16384), иначе, как и
+# без папки или изображений в ней, скрипт останавливается.
+
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+PACK_LAYER = 0
+PACK_USER = 8
+
+
+def _entry(name):
+	match = re.fullmatch(r"layer([0-7])\.pxl", name.lower())
+	if match:
+		return PACK_LAYER + int(match.group(1))
+	match = re.fullmatch(r"user(\d{3})\.pxl", name.lower())
+	if match and 1 <= int(match.group(1)) <= 255:
+		return PACK_USER + int(match.group(1)) - 1
+	return None
+
+
+def _run(command):
+	try:
+		result = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+	except OSError as error:
+		raise SystemExit("flash_images: %s: %s" % (command[0], error))
+	if result.returncode != 0:
+		raise SystemExit("flash_images: %s failed:\n%s" % (" ".join(command), result.stdout))
+	return result.stdout
+
+
+# pxltool из исходников tools/pxltool, пересобирается только при изменениях. Многоконфигурационные
+# генераторы (Visual Studio, Xcode) кладут программу в подпапку Release.
+def _pxltool(tools, build):
+	_run(["cmake", "-S", os.path.join(tools, "pxltool"), "-B", build, "-DCMAKE_BUILD_TYPE=Release"])
+	_run(["cmake", "--build", build, "--target", "pxltool", "--config", "Release"])
+	for folder in (build, os.path.join(build, "Release")):
+		for name in ("pxltool", "pxltool.exe"):
+			path = os.path.join(folder, name)
+			if os.path.isfile(path):
+				return path
+	raise SystemExit("flash_images: pxltool not found in %s" % build)
+
+
+def _load(path, pxltool, temp):
+	with open(path, "rb") as file:
+		data = file.read()
+	if data[:4] == b"PXL2":
+		return data
+
+	converted = os.path.join(temp, os.path.basename(path) + "2")
+	_run([pxltool, "convert", "rle", path, converted])
+	with open(converted, "rb") as file:
+		return file.read()
+
+
+def generate(source, output, budget, tools, build):
+	images = []
+	if source:
+		if not os.path.isdir(source):
+			raise SystemExit("flash_images: %s: folder not found" % source)
+		names = sorted(name for name in os.listdir(source) if _entry(name) is not None)
+		if not names:
+			raise SystemExit("flash_images: %s: no layerN.pxl or userNNN.pxl files" % source)
+
+		pxltool = _pxltool(tools, build)
+		with tempfile.TemporaryDirectory() as temp:
+			for name in names:
+				images.append((_entry(name), name, _load(os.path.join(source, name), pxltool, temp)))
+	images.sort()
+
+	total = sum(len(data) for _, _, data in images)
+	if total > budget:
+		raise SystemExit("flash_images: %d bytes exceed budget of %d bytes" % (total, budget))
+
+	lines = [
+		"#pragma once",
+		"",
+		"// Сгенерировано tools/flash_images.py из папки flash, не редактировать.",
+		"",
+		"namespace PxlFlash",
+		"{",
+	]
+	for idx, (entry, name, data) in enumerate(images):
+		lines.append("\t// %s, %d bytes." % (name, len(data)))
+		lines.append("\tstatic constexpr uint8_t image_%d[] =" % idx)
+		lines.append("\t{")
+		for pos in range(0, len(data), 16):
+			lines.append("\t\t" + " ".join("0x%02X," % byte for byte in data[pos:pos + 16]))
+		lines.append("\t};")
+		lines.append("")
+	lines.append("\tstatic constexpr image_t images[] =")
+	lines.append("\t{")
+	for idx, (entry, name, data) in enumerate(images):
+		lines.append("\t\t{%d, image_%d, sizeof(image_%d)}," % (entry, idx, idx))
+	lines.append("\t\t{0xFFFF, nullptr, 0},")
+	lines.append("\t};")
+	lines.append("}")
+	lines.append("")
+
+	os.makedirs(output, exist_ok=True)
+	path = os.path.join(output, "PxlFlashData.h")
+	text = "\n".join(lines)
+	if not os.path.exists(path) or open(path, encoding="utf-8").read() != text:
+		with open(path, "w", encoding="utf-8", newline="\n") as file:
+			file.write(text)
+
+	print("flash_images: %d images, %d of %d bytes" % (len(images), total, budget))
+	return path
+
+
+if __name__ == "__main__":
+	if len(sys.argv) < 3:
+		raise SystemExit("usage: flash_images.py <source dir> <output dir> [budget]")
+	tools = os.path.dirname(os.path.abspath(__file__))
+	generate(sys.argv[1], sys.argv[2], int(sys.argv[3]) if len(sys.argv) > 3 else 16384, tools, os.path.join(tempfile.gettempdir(), "flash_images_pxltool"))
+else:
+	Import("env")	# noqa: F821
+
+	folder = env.GetProjectOption("custom_flash_images", "").strip()	# noqa: F821
+	if folder:
+		project = env.subst("$PROJECT_DIR")	# noqa: F821
+		build = os.path.join(env.subst("$BUILD_DIR"), "pxltool")	# noqa: F821
+		generate(os.path.join(project, folder), os.path.join(project, "include"), int(env.GetProjectOption("custom_flash_budget", "16384")), os.path.join(project, "tools"), build)	# noqa: F821
@@ -0,0 +1,198 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include "PxlAtlasBuild.h"
+#include "PxlImage.h"
+
+struct atlas_script_t
+{
+	Pxl::script_desc_t desc;
+	std::vector<Pxl::script_step_t> steps;
+};
+
+// Шаг скрипта "dx,dy,frames,frame", frame - номер кадра спрайта или cycle.
+static bool _ParseStep(const std::string &text, Pxl::script_step_t &step)
+{
+	int dx, dy, frames;
+	char frame[16];
+	if(sscanf(text.c_str(), "%d,%d,%d,%15s", &dx, &dy, &frames, frame) != 4) return false;
+	if(dx < -128 || dx > 127 || dy < -128 || dy > 127 || frames < 1 || frames > 255) return false;
+
+	step.dx = dx;
+	step.dy = dy;
+	step.frames = frames;
+	if(strcmp(frame, "cycle") == 0)
+	{
+		step.sprite_frame = Pxl::STEP_FRAME_CYCLE;
+		return true;
+	}
+
+	char *end;
+	unsigned long value = strtoul(frame, &end, 10);
+	if(end == frame || *end != '\0' || value >= Pxl::STEP_FRAME_CYCLE) return false;
+	step.sprite_frame = value;
+
+	return true;
+}
+
+static bool _LoadSprite(const std::string &path, bool crop, const PxlDevice &device, PxlImage &image, std::string &error)
+{
+	if(PxlLoad(path, image, error) == false) return false;
+	if(crop == true) PxlCrop(image);
+
+	if(image.frames.empty() == true || image.frames.size() > 255)
+	{
+		error = "sprite needs 1..255 frames";
+		return false;
+	}
+	uint32_t size = (uint32_t)image.width * image.height * image.frames.size() * sizeof(Pxl::rgba_t);
+	if(size > device.sprite_arena)
+	{
+		error = std::to_string(size) + " bytes of pixels, the sprite arena is " + std::to_string(device.sprite_arena);
+		return false;
+	}
+
+	return true;
+}
+
+bool PxlAtlasBuild(const std::string &spec, const PxlDevice &device, const std::string &output, PxlAtlasStats &stats, std::string &error)
+{
+	std::ifstream in(spec);
+	if(!in)
+	{
+		error = "can't open file";
+		return false;
+	}
+	size_t slash = spec.find_last_of('/');
+	std::string dir = (slash == std::string::npos) ? "." : spec.substr(0, slash);
+
+	std::vector<PxlImage> sprites;
+	std::vector<atlas_script_t> scripts;
+	std::string line;
+	for(unsigned number = 1; std::getline(in, line); ++number)
+	{
+		std::string where = spec + ":" + std::to_string(number) + ": ";
+		size_t comment = line.find('#');
+		if(comment != std::string::npos) line.erase(comment);
+
+		std::istringstream tokens(line);
+		std::string command;
+		if(!(tokens >> command)) continue;
+
+		if(command == "sprite")
+		{
+			std::string file, option;
+			if(!(tokens >> file) || ((tokens >> option) && option != "crop") || sprites.size() >= 255)
+			{
+				error = where + "expected: sprite <file.pxl> [crop], up to 255 sprites";
+				return false;
+			}
+
+			PxlImage image;
+			if(_LoadSprite((file[0] == '/') ? file : dir + "/" + file, option == "crop", device, image, error) == false)
+			{
+				error = where + file + ": " + error;
+				return false;
+			}
+			sprites.push_back(image);
+		}
+		else if(command == "script")
+		{
+			atlas_script_t script = {};
+			std::string step;
+			while(tokens >> step)
+			{
+				Pxl::script_step_t value;
+				if(step == "loop" && script.steps.empty() == true)
+				{
+					script.desc.flags |= Pxl::SCRIPT_FLAG_LOOP;
+				}
+				else if(_ParseStep(step, value) == true)
+				{
+					script.steps.push_back(value);
+				}
+				else
+				{
+					error = where + "bad step: " + step;
+					return false;
+				}
+			}
+			if(script.steps.empty() == true || script.steps.size() > 255 || scripts.size() >= 255)
+			{
+				error = where + "expected: script [loop] <dx>,<dy>,<frames>,<frame|cycle> ..., up to 255 steps and scripts";
+				return false;
+			}
+			script.desc.step_count = script.steps.size();
+			scripts.push_back(script);
+		}
+		else
+		{
+			error = where + "unknown command: " + command;
+			return false;
+		}
+	}
+	if(sprites.empty() == true || scripts.empty() == true)
+	{
+		error = "atlas needs at least one sprite and one script";
+		return false;
+	}
+
+	// Кадр из шага скрипта прошивка ограничивает последним кадром спрайта, так что здесь он не проверяется.
+	Pxl::atlas_header_t header = {};
+	memcpy(header.magic, Pxl::ATLAS_MAGIC, sizeof(header.magic));
+	header.version = Pxl::ATLAS_VERSION;
+	header.sprite_count = sprites.size();
+	header.script_count = scripts.size();
+
+	std::vector<Pxl::sprite_desc_t> descs(sprites.size());
+	std::vector<uint8_t> data;
+	uint32_t base = sizeof(header) + descs.size() * sizeof(Pxl::sprite_desc_t) + scripts.size() * sizeof(Pxl::script_desc_t);
+
+	stats = PxlAtlasStats();
+	for(size_t i = 0; i < sprites.size(); ++i)
+	{
+		const PxlImage &image = sprites[i];
+		Pxl::sprite_desc_t &desc = descs[i];
+		memset(&desc, 0x00, sizeof(desc));
+		desc.width = image.width;
+		desc.height = image.height;
+		desc.frames = image.frames.size();
+		desc.offset = base + data.size();
+		for(const auto &frame : image.frames)
+		{
+			const uint8_t *pixels = (const uint8_t *)frame.data();
+			data.insert(data.end(), pixels, pixels + frame.size() * sizeof(Pxl::rgba_t));
+		}
+
+		uint32_t size = data.size() - (desc.offset - base);
+		if(size > stats.largest) stats.largest = size;
+	}
+	for(atlas_script_t &script : scripts)
+	{
+		script.desc.offset = base + data.size();
+		const uint8_t *steps = (const uint8_t *)script.steps.data();
+		data.insert(data.end(), steps, steps + script.steps.size() * sizeof(Pxl::script_step_t));
+	}
+
+	std::ofstream out(output, std::ios::binary);
+	out.write((const char *)&header, sizeof(header));
+	out.write((const char *)descs.data(), descs.size() * sizeof(Pxl::sprite_desc_t));
+	for(const atlas_script_t &script : scripts)
+	{
+		out.write((const char *)&script.desc, sizeof(script.desc));
+	}
+	out.write((const char *)data.data(), data.size());
+	if(!out)
+	{
+		error = "can't write file";
+		return false;
+	}
+	stats.sprites = sprites.size();
+	stats.scripts = scripts.size();
+	stats.size = base + data.size();
+
+	return true;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <PxlFormat.h>
+#include "PxlOptimize.h"
+
+struct PxlAtlasStats
+{
+	uint8_t sprites = 0;
+	uint8_t scripts = 0;
+	uint32_t largest = 0;		// Пиксели самого большого спрайта, байт.
+	size_t size = 0;			// Размер атласа.
+};
+
+/*
+	Атлас спрайтов (Pxl::ATLAS_MAGIC) по описанию spec, по строке на спрайт или скрипт, # - комментарий:
+		sprite <file.pxl> [crop]
+		script [loop] <dx>,<dy>,<frames>,<frame|cycle> ...
+	Спрайт - все кадры файла PXL/PXL2, crop - обрезать по непрозрачным пикселям. Пути - от папки spec.
+	Номера спрайтов и скриптов - по порядку строк, с 0. Спрайт, который не помещается в память
+	спрайтов прошивки (device.sprite_arena), - ошибка.
+*/
+bool PxlAtlasBuild(const std::string &spec, const PxlDevice &device, const std::string &output, PxlAtlasStats &stats, std::string &error);
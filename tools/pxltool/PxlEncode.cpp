@@ -0,0 +1,443 @@
+#include <string.h>
+#include <map>
+#include "PxlEncode.h"
+
+static bool _IsSame(const Pxl::rgba_t &a, const Pxl::rgba_t &b)
+{
+	// Полностью прозрачные пиксели равны независимо от цвета.
+	if(a.a == 0 && b.a == 0) return true;
+
+	return (memcmp(&a, &b, sizeof(a)) == 0);
+}
+
+static void _PushU16(std::vector<uint8_t> &out, uint16_t value)
+{
+	out.push_back(value & 0xFF);
+	out.push_back(value >> 8);
+
+	return;
+}
+
+static void _PushColor(std::vector<uint8_t> &out, const Pxl::rgba_t &color)
+{
+	const uint8_t *bytes = (const uint8_t *)&color;
+	out.insert(out.end(), bytes, bytes + sizeof(color));
+
+	return;
+}
+
+bool PxlEncodeRgba(const PxlImage &image, std::vector<uint8_t> &out)
+{
+	for(const auto &frame : image.frames)
+	{
+		for(const auto &pixel : frame)
+		{
+			_PushColor(out, pixel);
+		}
+	}
+
+	return true;
+}
+
+static void _EncodeRleRows(const PxlImage &image, const std::vector<Pxl::rgba_t> &frame, std::vector<uint8_t> &out)
+{
+	for(uint16_t y = 0; y < image.height; ++y)
+	{
+		const Pxl::rgba_t *row = &frame[y * image.width];
+		uint16_t x = 0;
+		while(x < image.width)
+		{
+			uint16_t run = 1;
+			while(x + run < image.width && run < Pxl::RLE_MAX_RUN && _IsSame(row[x + run], row[x]) == true)
+			{
+				++run;
+			}
+
+			if(row[x].a == 0)
+			{
+				out.push_back(run - 1);
+			}
+			else
+			{
+				out.push_back(Pxl::RLE_COLOR | (run - 1));
+				_PushColor(out, row[x]);
+			}
+			x += run;
+		}
+	}
+
+	return;
+}
+
+// Участки строк, где кадр отличается от предыдущего.
+static void _EncodeSpans(const PxlImage &image, const std::vector<Pxl::rgba_t> &prev, const std::vector<Pxl::rgba_t> &frame, std::vector<uint8_t> &out)
+{
+	for(uint16_t y = 0; y < image.height; ++y)
+	{
+		const Pxl::rgba_t *a = &prev[y * image.width];
+		const Pxl::rgba_t *b = &frame[y * image.width];
+		uint16_t x = 0;
+		while(x < image.width)
+		{
+			if(_IsSame(a[x], b[x]) == true)
+			{
+				++x;
+				continue;
+			}
+
+			uint16_t count = 1;
+			while(x + count < image.width && count < Pxl::DELTA_MAX_SPAN && _IsSame(a[x + count], b[x + count]) == false)
+			{
+				++count;
+			}
+
+			out.push_back(x);
+			out.push_back(y);
+			out.push_back(count);
+			for(uint16_t i = 0; i < count; ++i)
+			{
+				_PushColor(out, b[x + i]);
+			}
+			x += count;
+		}
+	}
+
+	return;
+}
+
+static void _PushFrame(std::vector<uint8_t> &out, const std::vector<uint8_t> &data)
+{
+	_PushU16(out, data.size());
+	out.insert(out.end(), data.begin(), data.end());
+
+	return;
+}
+
+bool PxlEncodeRle(const PxlImage &image, std::vector<uint8_t> &out)
+{
+	std::vector<uint8_t> data;
+	for(const auto &frame : image.frames)
+	{
+		data.clear();
+		_EncodeRleRows(image, frame, data);
+		if(data.size() > 0xFFFF) return false;
+
+		_PushFrame(out, data);
+	}
+
+	return true;
+}
+
+/*
+	Интервал ключевых кадров подбирается по сумме размера файла и среднего объёма чтения
+	при переходе на произвольный кадр: ключевой кадр и все дельта-кадры после него.
+	Частые ключевые кадры ускоряют переход, редкие уменьшают файл.
+*/
+uint16_t PxlDeltaInterval(const PxlImage &image)
+{
+	size_t count = image.frames.size();
+	std::vector<size_t> key_size(count);
+	std::vector<size_t> delta_size(count);
+	std::vector<uint8_t> data;
+	for(size_t i = 0; i < count; ++i)
+	{
+		data.clear();
+		_EncodeRleRows(image, image.frames[i], data);
+		key_size[i] = sizeof(uint16_t) + 1 + data.size();
+
+		data.clear();
+		if(i > 0) _EncodeSpans(image, image.frames[i - 1], image.frames[i], data);
+		delta_size[i] = sizeof(uint16_t) + 1 + data.size();
+	}
+
+	uint16_t best = 1;
+	size_t best_cost = SIZE_MAX;
+	for(size_t interval = 1; interval <= count && interval <= 0xFFFF; ++interval)
+	{
+		size_t file_size = ((count + interval - 1) / interval) * sizeof(uint32_t);
+		size_t seek_total = 0;
+		size_t chain = 0;
+		for(size_t i = 0; i < count; ++i)
+		{
+			size_t size = (i % interval == 0) ? key_size[i] : delta_size[i];
+			chain = (i % interval == 0) ? size : (chain + size);
+			file_size += size;
+			seek_total += chain;
+		}
+
+		size_t cost = file_size + seek_total / count;
+		if(cost < best_cost)
+		{
+			best_cost = cost;
+			best = interval;
+		}
+	}
+
+	return best;
+}
+
+bool PxlEncodeDelta(const PxlImage &image, uint16_t key_interval, uint32_t base, std::vector<uint8_t> &out)
+{
+	if(key_interval == 0) return false;
+
+	size_t count = image.frames.size();
+	size_t keys = (count + key_interval - 1) / key_interval;
+	size_t table = out.size();
+	out.resize(table + keys * sizeof(uint32_t));
+
+	std::vector<uint8_t> data;
+	for(size_t i = 0; i < count; ++i)
+	{
+		data.clear();
+		if(i % key_interval == 0)
+		{
+			uint32_t offset = base + out.size();
+			memcpy(&out[table + (i / key_interval) * sizeof(offset)], &offset, sizeof(offset));
+
+			data.push_back(Pxl::DELTA_KEYFRAME);
+			_EncodeRleRows(image, image.frames[i], data);
+		}
+		else
+		{
+			data.push_back(Pxl::DELTA_SPANS);
+			_EncodeSpans(image, image.frames[i - 1], image.frames[i], data);
+		}
+		if(data.size() > 0xFFFF) return false;
+
+		_PushFrame(out, data);
+	}
+
+	return true;
+}
+
+// Палитра из всех цветов анимации, прозрачные пиксели - один цвет {0, 0, 0, 0}.
+static void _BuildPalette(const PxlImage &image, std::vector<Pxl::rgba_t> &palette, std::map<uint32_t, uint8_t> &index, size_t max)
+{
+	for(const auto &frame : image.frames)
+	{
+		for(const auto &pixel : frame)
+		{
+			Pxl::rgba_t color = (pixel.a == 0) ? Pxl::rgba_t{0, 0, 0, 0} : pixel;
+			uint32_t key;
+			memcpy(&key, &color, sizeof(key));
+			if(index.count(key) > 0) continue;
+			if(palette.size() >= max) return;
+
+			index[key] = palette.size();
+			palette.push_back(color);
+		}
+	}
+
+	return;
+}
+
+bool PxlEncodePalette(const PxlImage &image, Pxl::encoding_t encoding, uint16_t &palette_count, std::vector<uint8_t> &out)
+{
+	size_t max = (encoding == Pxl::ENCODING_PAL4) ? 16 : Pxl::PALETTE_MAX;
+	std::vector<Pxl::rgba_t> palette;
+	std::map<uint32_t, uint8_t> index;
+	_BuildPalette(image, palette, index, max + 1);
+	if(palette.size() > max) return false;
+
+	palette_count = palette.size();
+	for(const auto &color : palette)
+	{
+		_PushColor(out, color);
+	}
+
+	for(const auto &frame : image.frames)
+	{
+		for(uint16_t y = 0; y < image.height; ++y)
+		{
+			const Pxl::rgba_t *row = &frame[y * image.width];
+			for(uint16_t x = 0; x < image.width; ++x)
+			{
+				Pxl::rgba_t color = (row[x].a == 0) ? Pxl::rgba_t{0, 0, 0, 0} : row[x];
+				uint32_t key;
+				memcpy(&key, &color, sizeof(key));
+				uint8_t idx = index[key];
+
+				if(encoding == Pxl::ENCODING_PAL8) out.push_back(idx);
+				else if((x & 0x01) == 0) out.push_back(idx << 4);
+				else out.back() |= idx;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool PxlFrameOffsets(const uint8_t *data, size_t length, const Pxl::layer_header_t &header, std::vector<uint32_t> &offsets)
+{
+	offsets.clear();
+	switch(header.encoding)
+	{
+		case Pxl::ENCODING_RLE:
+		case Pxl::ENCODING_DELTA:
+		{
+			size_t pos = 0;
+			if(header.encoding == Pxl::ENCODING_DELTA)
+			{
+				pos = ((header.frames + header.key_interval - 1) / header.key_interval) * sizeof(uint32_t);
+			}
+			for(uint16_t i = 0; i < header.frames; ++i)
+			{
+				if(pos + sizeof(uint16_t) > length) return false;
+
+				offsets.push_back(pos);
+				pos += sizeof(uint16_t) + (data[pos] | (data[pos + 1] << 8));
+			}
+			break;
+		}
+		default:
+		{
+			size_t row_bytes = header.width * sizeof(Pxl::rgba_t);
+			if(header.encoding == Pxl::ENCODING_PAL4) row_bytes = (header.width + 1) / 2;
+			if(header.encoding == Pxl::ENCODING_PAL8) row_bytes = header.width;
+
+			size_t base = header.palette_count * sizeof(Pxl::rgba_t);
+			for(uint16_t i = 0; i < header.frames; ++i)
+			{
+				offsets.push_back(base + (size_t)i * header.height * row_bytes);
+			}
+			break;
+		}
+	}
+
+	return true;
+}
+
+bool PxlDecodeRgba(const uint8_t *data, size_t length, PxlImage &image)
+{
+	size_t frame_pixels = image.width * image.height;
+	if(length < image.frames.size() * frame_pixels * sizeof(Pxl::rgba_t)) return false;
+
+	for(auto &frame : image.frames)
+	{
+		frame.resize(frame_pixels);
+		memcpy(frame.data(), data, frame_pixels * sizeof(Pxl::rgba_t));
+		data += frame_pixels * sizeof(Pxl::rgba_t);
+	}
+
+	return true;
+}
+
+// Строки RLE с позиции pos до end, кадр заполняется целиком.
+static bool _DecodeRleRows(const uint8_t *data, size_t &pos, size_t end, const PxlImage &image, std::vector<Pxl::rgba_t> &frame)
+{
+	frame.assign(image.width * image.height, Pxl::rgba_t{0, 0, 0, 0});
+
+	size_t idx = 0;
+	while(idx < frame.size())
+	{
+		if(pos >= end) return false;
+
+		uint8_t ctrl = data[pos++];
+		size_t run = (ctrl & ~Pxl::RLE_COLOR) + 1;
+		if(idx % image.width + run > image.width) return false;
+
+		if(ctrl & Pxl::RLE_COLOR)
+		{
+			if(pos + sizeof(Pxl::rgba_t) > end) return false;
+
+			Pxl::rgba_t color;
+			memcpy(&color, &data[pos], sizeof(color));
+			pos += sizeof(color);
+			for(size_t i = 0; i < run; ++i)
+			{
+				frame[idx + i] = color;
+			}
+		}
+		idx += run;
+	}
+
+	return true;
+}
+
+// Границы очередного кадра с префиксом размера.
+static bool _NextFrame(const uint8_t *data, size_t length, size_t &pos, size_t &end)
+{
+	if(pos + sizeof(uint16_t) > length) return false;
+	end = pos + sizeof(uint16_t) + (data[pos] | (data[pos + 1] << 8));
+	pos += sizeof(uint16_t);
+
+	return (end <= length);
+}
+
+bool PxlDecodePalette(const uint8_t *data, size_t length, Pxl::encoding_t encoding, uint16_t palette_count, PxlImage &image)
+{
+	size_t row_bytes = (encoding == Pxl::ENCODING_PAL4) ? (image.width + 1) / 2 : image.width;
+	size_t palette_bytes = palette_count * sizeof(Pxl::rgba_t);
+	if(palette_count == 0 || length < palette_bytes + image.frames.size() * image.height * row_bytes) return false;
+
+	const Pxl::rgba_t *palette = (const Pxl::rgba_t *)data;
+	data += palette_bytes;
+	for(auto &frame : image.frames)
+	{
+		frame.resize(image.width * image.height);
+		for(uint16_t y = 0; y < image.height; ++y)
+		{
+			for(uint16_t x = 0; x < image.width; ++x)
+			{
+				uint8_t idx = (encoding == Pxl::ENCODING_PAL8) ? data[x] : ((data[x >> 1] >> ((x & 0x01) ? 0 : 4)) & 0x0F);
+				if(idx >= palette_count) return false;
+
+				frame[y * image.width + x] = palette[idx];
+			}
+			data += row_bytes;
+		}
+	}
+
+	return true;
+}
+
+bool PxlDecodeRle(const uint8_t *data, size_t length, PxlImage &image)
+{
+	size_t pos = 0;
+	size_t end = 0;
+	for(auto &frame : image.frames)
+	{
+		if(_NextFrame(data, length, pos, end) == false) return false;
+		if(_DecodeRleRows(data, pos, end, image, frame) == false || pos != end) return false;
+	}
+
+	return true;
+}
+
+bool PxlDecodeDelta(const uint8_t *data, size_t length, uint16_t key_interval, PxlImage &image)
+{
+	if(key_interval == 0) return false;
+
+	size_t pos = ((image.frames.size() + key_interval - 1) / key_interval) * sizeof(uint32_t);
+	size_t end = 0;
+	for(size_t i = 0; i < image.frames.size(); ++i)
+	{
+		auto &frame = image.frames[i];
+		if(_NextFrame(data, length, pos, end) == false || pos >= end) return false;
+
+		uint8_t type = data[pos++];
+		if(type == Pxl::DELTA_KEYFRAME)
+		{
+			if(_DecodeRleRows(data, pos, end, image, frame) == false || pos != end) return false;
+			continue;
+		}
+		if(type != Pxl::DELTA_SPANS || i == 0) return false;
+
+		frame = image.frames[i - 1];
+		while(pos < end)
+		{
+			if(pos + 3 > end) return false;
+
+			size_t x = data[pos];
+			size_t y = data[pos + 1];
+			size_t count = data[pos + 2];
+			pos += 3;
+			if(x + count > image.width || y >= image.height || pos + count * sizeof(Pxl::rgba_t) > end) return false;
+
+			memcpy(&frame[y * image.width + x], &data[pos], count * sizeof(Pxl::rgba_t));
+			pos += count * sizeof(Pxl::rgba_t);
+		}
+	}
+
+	return true;
+}
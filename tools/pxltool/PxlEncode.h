@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "PxlImage.h"
+
+// Данные кадров в заданной кодировке, без заголовка.
+bool PxlEncodeRgba(const PxlImage &image, std::vector<uint8_t> &out);
+bool PxlEncodeRle(const PxlImage &image, std::vector<uint8_t> &out);
+
+// Дельта-кадры: таблица ключевых кадров и кадры, base - смещение данных от начала файла.
+bool PxlEncodeDelta(const PxlImage &image, uint16_t key_interval, uint32_t base, std::vector<uint8_t> &out);
+uint16_t PxlDeltaInterval(const PxlImage &image);
+
+// Палитра и индексы ENCODING_PAL4 или ENCODING_PAL8; false, если цветов больше, чем вмещает кодировка.
+bool PxlEncodePalette(const PxlImage &image, Pxl::encoding_t encoding, uint16_t &palette_count, std::vector<uint8_t> &out);
+
+// Смещения кадров относительно начала данных, для таблицы кадров.
+bool PxlFrameOffsets(const uint8_t *data, size_t length, const Pxl::layer_header_t &header, std::vector<uint32_t> &offsets);
+
+// Разбор данных кадров; размеры и кол-во кадров в image уже заданы.
+bool PxlDecodeRgba(const uint8_t *data, size_t length, PxlImage &image);
+bool PxlDecodeRle(const uint8_t *data, size_t length, PxlImage &image);
+bool PxlDecodePalette(const uint8_t *data, size_t length, Pxl::encoding_t encoding, uint16_t palette_count, PxlImage &image);
+bool PxlDecodeDelta(const uint8_t *data, size_t length, uint16_t key_interval, PxlImage &image);
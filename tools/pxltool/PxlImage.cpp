@@ -0,0 +1,249 @@
+#include <string.h>
+#include <fstream>
+#include <iterator>
+#include "PxlImage.h"
+#include "PxlEncode.h"
+
+/*
+	Заголовок PXL из редактора pxledit.starpixel.org в том виде, как его читает MatrixLed<>:
+	"PXL", версия, ширина, высота, кол-во кадров, интервал кадров в мс, за заголовком
+	rgba_t[frames][height][width]. Размер файла проверяется по заголовку, так что файл
+	другого вида не будет принят за PXL.
+*/
+struct __attribute__((__packed__)) legacy_header_t
+{
+	char magic[3];
+	uint8_t version;
+	uint8_t width;
+	uint8_t height;
+	uint16_t frames;
+	uint16_t delay;
+	uint8_t reserved[6];
+};
+
+static bool _ReadFile(const std::string &path, std::vector<uint8_t> &data)
+{
+	std::ifstream file(path, std::ios::binary);
+	if(!file) return false;
+
+	data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+	return true;
+}
+
+static bool _LoadLegacy(const std::vector<uint8_t> &data, PxlImage &image, std::string &error)
+{
+	legacy_header_t header;
+	if(data.size() < sizeof(header) || memcmp(data.data(), "PXL", 3) != 0)
+	{
+		error = "unknown file format";
+		return false;
+	}
+	memcpy(&header, data.data(), sizeof(header));
+
+	size_t expected = sizeof(header) + (size_t)header.frames * header.width * header.height * sizeof(Pxl::rgba_t);
+	if(header.width == 0 || header.height == 0 || header.frames == 0 || data.size() != expected)
+	{
+		error = "PXL header does not match file size";
+		return false;
+	}
+
+	image.width = header.width;
+	image.height = header.height;
+	image.delay = header.delay;
+	image.flags = 0;
+	image.frames.resize(header.frames);
+
+	return PxlDecodeRgba(&data[sizeof(header)], data.size() - sizeof(header), image);
+}
+
+static bool _LoadPxl2(const std::vector<uint8_t> &data, PxlImage &image, std::string &error)
+{
+	Pxl::layer_header_t header = {};
+	memcpy(&header, data.data(), 8);
+	if(header.version != Pxl::LAYER_VERSION || header.header_size < 8 || header.header_size > data.size())
+	{
+		error = "unsupported PXL2 header";
+		return false;
+	}
+	memcpy(&header, data.data(), (header.header_size < sizeof(header)) ? header.header_size : sizeof(header));
+
+	image.width = header.width;
+	image.height = header.height;
+	image.x = header.x;
+	image.y = header.y;
+	image.delay = header.delay;
+	image.flags = header.flags;
+	image.mode = header.mode;
+	image.loop_start = header.loop_start;
+	image.loop_end = header.loop_end;
+	image.frames.resize(header.frames);
+
+	image.durations.clear();
+	if(header.frame_table > 0)
+	{
+		if(header.frame_table + (size_t)header.frames * sizeof(Pxl::frame_entry_t) > data.size())
+		{
+			error = "PXL2 frame table is out of file";
+			return false;
+		}
+		for(uint16_t i = 0; i < header.frames; ++i)
+		{
+			Pxl::frame_entry_t entry;
+			memcpy(&entry, &data[header.frame_table + i * sizeof(entry)], sizeof(entry));
+			image.durations.push_back(entry.duration);
+		}
+	}
+
+	const uint8_t *payload = &data[header.header_size];
+	size_t length = data.size() - header.header_size;
+	bool result = false;
+	switch(header.encoding)
+	{
+		case Pxl::ENCODING_RGBA: { result = PxlDecodeRgba(payload, length, image); break; }
+		case Pxl::ENCODING_RLE: { result = PxlDecodeRle(payload, length, image); break; }
+		case Pxl::ENCODING_DELTA: { result = PxlDecodeDelta(payload, length, header.key_interval, image); break; }
+		case Pxl::ENCODING_PAL4:
+		case Pxl::ENCODING_PAL8: { result = PxlDecodePalette(payload, length, (Pxl::encoding_t)header.encoding, header.palette_count, image); break; }
+		default: { error = "unsupported PXL2 encoding"; return false; }
+	}
+	if(result == false) error = "corrupted PXL2 frame data";
+
+	return result;
+}
+
+bool PxlLoad(const std::string &path, PxlImage &image, std::string &error)
+{
+	std::vector<uint8_t> data;
+	if(_ReadFile(path, data) == false)
+	{
+		error = "can't read file";
+		return false;
+	}
+
+	if(data.size() >= 8 && memcmp(data.data(), Pxl::LAYER_MAGIC, sizeof(Pxl::LAYER_MAGIC)) == 0)
+	{
+		return _LoadPxl2(data, image, error);
+	}
+
+	return _LoadLegacy(data, image, error);
+}
+
+bool PxlSerialize(const PxlImage &image, Pxl::encoding_t encoding, std::vector<uint8_t> &out, std::string &error)
+{
+	Pxl::layer_header_t header = {};
+	std::vector<uint8_t> payload;
+	bool result = false;
+
+	// Прошивка смешивает соседние кадры только без сжатия и с палитрой, у rle и delta флаг бы не работал.
+	if((image.flags & Pxl::LAYER_FLAG_TWEEN) && (encoding == Pxl::ENCODING_RLE || encoding == Pxl::ENCODING_DELTA))
+	{
+		error = "tween needs rgba, pal4 or pal8 encoding";
+		return false;
+	}
+
+	switch(encoding)
+	{
+		case Pxl::ENCODING_RGBA: { result = PxlEncodeRgba(image, payload); break; }
+		case Pxl::ENCODING_RLE: { result = PxlEncodeRle(image, payload); break; }
+		case Pxl::ENCODING_DELTA:
+		{
+			header.key_interval = PxlDeltaInterval(image);
+			header.key_table = sizeof(header);
+			result = PxlEncodeDelta(image, header.key_interval, sizeof(header), payload);
+			break;
+		}
+		case Pxl::ENCODING_PAL4:
+		case Pxl::ENCODING_PAL8:
+		{
+			uint16_t palette_count = 0;
+			result = PxlEncodePalette(image, encoding, palette_count, payload);
+			header.palette_count = palette_count;
+			break;
+		}
+	}
+	if(result == false)
+	{
+		error = "frame does not fit the encoding";
+		return false;
+	}
+
+	memcpy(header.magic, Pxl::LAYER_MAGIC, sizeof(header.magic));
+	header.version = Pxl::LAYER_VERSION;
+	header.flags = image.flags;
+	header.header_size = sizeof(header);
+	header.width = image.width;
+	header.height = image.height;
+	header.x = image.x;
+	header.y = image.y;
+	header.frames = image.frames.size();
+	header.delay = image.delay;
+	header.encoding = encoding;
+	header.mode = image.mode;
+	header.loop_start = image.loop_start;
+	header.loop_end = image.loop_end;
+
+	// Таблица кадров нужна для разных длительностей и для быстрого перехода по кадрам RLE.
+	std::vector<uint8_t> table;
+	if(image.durations.empty() == false || encoding == Pxl::ENCODING_RLE)
+	{
+		std::vector<uint32_t> offsets;
+		if(PxlFrameOffsets(payload.data(), payload.size(), header, offsets) == false)
+		{
+			error = "can't build frame table";
+			return false;
+		}
+		for(size_t i = 0; i < offsets.size(); ++i)
+		{
+			Pxl::frame_entry_t entry;
+			entry.offset = sizeof(header) + offsets[i];
+			entry.duration = (i < image.durations.size()) ? image.durations[i] : 0;
+			table.insert(table.end(), (const uint8_t *)&entry, (const uint8_t *)&entry + sizeof(entry));
+		}
+		header.frame_table = sizeof(header) + payload.size();
+	}
+
+	const uint8_t *bytes = (const uint8_t *)&header;
+	out.assign(bytes, bytes + sizeof(header));
+	out.insert(out.end(), payload.begin(), payload.end());
+	out.insert(out.end(), table.begin(), table.end());
+
+	return true;
+}
+
+bool PxlSave(const std::string &path, const PxlImage &image, Pxl::encoding_t encoding, std::string &error)
+{
+	std::vector<uint8_t> data;
+	if(PxlSerialize(image, encoding, data, error) == false) return false;
+
+	std::ofstream file(path, std::ios::binary);
+	file.write((const char *)data.data(), data.size());
+	if(!file)
+	{
+		error = "can't write file";
+		return false;
+	}
+
+	return true;
+}
+
+static const char *_encoding_names[] = {"rgba", "rle", "delta", "pal4", "pal8"};
+
+const char *PxlEncodingName(uint8_t encoding)
+{
+	return (encoding < sizeof(_encoding_names) / sizeof(_encoding_names[0])) ? _encoding_names[encoding] : "unknown";
+}
+
+bool PxlEncodingParse(const std::string &name, Pxl::encoding_t &encoding)
+{
+	for(uint8_t i = 0; i < sizeof(_encoding_names) / sizeof(_encoding_names[0]); ++i)
+	{
+		if(name == _encoding_names[i])
+		{
+			encoding = (Pxl::encoding_t)i;
+			return true;
+		}
+	}
+
+	return false;
+}
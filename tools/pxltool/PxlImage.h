@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <PxlFormat.h>
+
+// Анимация в памяти: кадры без сжатия, строки сверху вниз.
+struct PxlImage
+{
+	uint8_t width = 0;
+	uint8_t height = 0;
+	uint8_t x = 0;						// Положение на панели.
+	uint8_t y = 0;
+	uint16_t delay = 0;
+	uint8_t flags = 0;
+	uint8_t mode = Pxl::PLAY_LOOP;
+	uint16_t loop_start = 0;
+	uint16_t loop_end = 0;
+	std::vector<uint16_t> durations;	// Длительности кадров, мс; пустой - у всех delay.
+	std::vector<std::vector<Pxl::rgba_t>> frames;
+};
+
+// Загрузка PXL из редактора или PXL2 в любой поддерживаемой кодировке.
+bool PxlLoad(const std::string &path, PxlImage &image, std::string &error);
+
+// Файл PXL2 в кодировке encoding в памяти и на диске.
+bool PxlSerialize(const PxlImage &image, Pxl::encoding_t encoding, std::vector<uint8_t> &out, std::string &error);
+bool PxlSave(const std::string &path, const PxlImage &image, Pxl::encoding_t encoding, std::string &error);
+
+// Имя кодировки для командной строки и обратно.
+const char *PxlEncodingName(uint8_t encoding);
+bool PxlEncodingParse(const std::string &name, Pxl::encoding_t &encoding);
@@ -0,0 +1,222 @@
+#include <string.h>
+#include "PxlOptimize.h"
+#include "PxlEncode.h"
+
+bool PxlCheck(const PxlImage &image, const PxlDevice &device, std::string &error)
+{
+	if(image.frames.empty() == true)
+	{
+		error = "no frames";
+		return false;
+	}
+	if(image.x + image.width > device.width || image.y + image.height > device.height)
+	{
+		error = "image " + std::to_string(image.width) + "x" + std::to_string(image.height) + " at " + std::to_string(image.x) + "," + std::to_string(image.y) + " is out of panel " + std::to_string(device.width) + "x" + std::to_string(device.height);
+		return false;
+	}
+	if(image.loop_end >= image.frames.size() || image.loop_start > image.loop_end)
+	{
+		if(image.loop_end != 0 || image.loop_start != 0)
+		{
+			error = "loop range is out of frames";
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool _IsSameFrame(const std::vector<Pxl::rgba_t> &a, const std::vector<Pxl::rgba_t> &b)
+{
+	for(size_t i = 0; i < a.size(); ++i)
+	{
+		if(a[i].a == 0 && b[i].a == 0) continue;
+		if(memcmp(&a[i], &b[i], sizeof(a[i])) != 0) return false;
+	}
+
+	return true;
+}
+
+/*
+	Кадр не объединяется с предыдущим, если он начинает повтор (loop_start), стоит после loop_end
+	или включена интерполяция: смешивание шло бы дольше, чем было нарисовано.
+*/
+void PxlMergeFrames(PxlImage &image)
+{
+	if((image.flags & Pxl::LAYER_FLAG_TWEEN) || image.frames.size() < 2) return;
+
+	uint16_t loop_end = (image.loop_end == 0) ? image.frames.size() - 1 : image.loop_end;
+	std::vector<uint16_t> durations = image.durations;
+	if(durations.empty() == true) durations.assign(image.frames.size(), 0);
+
+	std::vector<std::vector<Pxl::rgba_t>> frames;
+	std::vector<uint16_t> merged;
+	uint16_t loop_start = 0;
+	uint16_t new_end = 0;
+	bool changed = false;
+	for(size_t i = 0; i < image.frames.size(); ++i)
+	{
+		uint32_t duration = (durations[i] > 0) ? durations[i] : image.delay;
+		if(i > 0 && i != image.loop_start && i <= loop_end && _IsSameFrame(image.frames[i], frames.back()) == true && merged.back() + duration <= 0xFFFF)
+		{
+			merged.back() += duration;
+			changed = true;
+		}
+		else
+		{
+			frames.push_back(image.frames[i]);
+			merged.push_back(duration);
+		}
+		if(i == image.loop_start) loop_start = frames.size() - 1;
+		if(i == loop_end) new_end = frames.size() - 1;
+	}
+	if(changed == false) return;
+
+	image.frames = frames;
+	image.durations = merged;
+	image.loop_start = loop_start;
+	image.loop_end = (image.loop_end == 0) ? 0 : new_end;
+
+	return;
+}
+
+bool PxlBoundingBox(const PxlImage &image, uint8_t &x, uint8_t &y, uint8_t &width, uint8_t &height)
+{
+	int left = image.width, top = image.height, right = -1, bottom = -1;
+	for(const auto &frame : image.frames)
+	{
+		for(int py = 0; py < image.height; ++py)
+		{
+			for(int px = 0; px < image.width; ++px)
+			{
+				if(frame[py * image.width + px].a == 0) continue;
+
+				if(px < left) left = px;
+				if(px > right) right = px;
+				if(py < top) top = py;
+				if(py > bottom) bottom = py;
+			}
+		}
+	}
+	if(right < 0) return false;
+
+	x = left;
+	y = top;
+	width = right - left + 1;
+	height = bottom - top + 1;
+
+	return true;
+}
+
+void PxlCrop(PxlImage &image)
+{
+	uint8_t x, y, width, height;
+	if(PxlBoundingBox(image, x, y, width, height) == false) return;
+	if(width == image.width && height == image.height) return;
+
+	for(auto &frame : image.frames)
+	{
+		std::vector<Pxl::rgba_t> cropped(width * height);
+		for(uint8_t row = 0; row < height; ++row)
+		{
+			memcpy(&cropped[row * width], &frame[(y + row) * image.width + x], width * sizeof(Pxl::rgba_t));
+		}
+		frame.swap(cropped);
+	}
+	image.x += x;
+	image.y += y;
+	image.width = width;
+	image.height = height;
+
+	return;
+}
+
+// Средний размер кадра RLE или дельта-кадра с префиксом размера, байт.
+static uint32_t _AverageFrame(const std::vector<uint8_t> &file, const Pxl::layer_header_t &header)
+{
+	std::vector<uint32_t> offsets;
+	size_t end = (header.frame_table > 0) ? header.frame_table : file.size();
+	if(PxlFrameOffsets(&file[header.header_size], end - header.header_size, header, offsets) == false || offsets.empty() == true) return 0;
+
+	return (end - header.header_size - offsets[0]) / offsets.size();
+}
+
+// Чтение с карты при показе по модели MatrixLayers<>: кадры без сжатия и RLE читаются при каждой
+// перерисовке (с интерполяцией - два кадра), дельта-кадры - при смене кадра, кэшированный файл - никогда.
+static void _Estimate(const PxlImage &image, const PxlDevice &device, const std::vector<uint8_t> &file, PxlReport &report)
+{
+	Pxl::layer_header_t header;
+	memcpy(&header, file.data(), sizeof(header));
+
+	uint32_t duration = 0;
+	for(size_t i = 0; i < image.frames.size(); ++i)
+	{
+		duration += (i < image.durations.size() && image.durations[i] > 0) ? image.durations[i] : image.delay;
+	}
+	duration /= image.frames.size();
+	bool animated = (image.frames.size() > 1 && duration > 0);
+
+	report.size = file.size();
+	report.ram = header.palette_count * sizeof(Pxl::rgba_t);
+	if(header.encoding == Pxl::ENCODING_DELTA) report.ram = (uint32_t)image.width * image.height * sizeof(Pxl::rgba_t);
+	report.cached = (animated == true && image.mode != Pxl::PLAY_ONCE && report.ram + file.size() <= device.layer_arena);
+	if(report.cached == true) report.ram += file.size();
+
+	uint32_t renders = 1000 / device.render_delay;
+	uint32_t frame_bytes = 0;
+	switch(header.encoding)
+	{
+		case Pxl::ENCODING_RLE: { frame_bytes = _AverageFrame(file, header); break; }
+		case Pxl::ENCODING_DELTA: { frame_bytes = _AverageFrame(file, header); renders = animated ? (1000 / duration) : 0; break; }
+		case Pxl::ENCODING_PAL4: { frame_bytes = (image.width + 1) / 2 * image.height; break; }
+		case Pxl::ENCODING_PAL8: { frame_bytes = image.width * image.height; break; }
+		default: { frame_bytes = image.width * image.height * sizeof(Pxl::rgba_t); break; }
+	}
+	if(header.encoding != Pxl::ENCODING_RLE && header.encoding != Pxl::ENCODING_DELTA && animated == true && (image.flags & Pxl::LAYER_FLAG_TWEEN)) frame_bytes *= 2;
+	report.sd_rate = (report.cached == true) ? 0 : frame_bytes * renders;
+
+	return;
+}
+
+bool PxlOptimize(PxlImage &image, const PxlDevice &device, std::vector<uint8_t> &out, PxlReport &report, std::string &error)
+{
+	if(PxlCheck(image, device, error) == false) return false;
+
+	report = PxlReport();
+	report.frames_in = image.frames.size();
+	PxlMergeFrames(image);
+	report.frames_out = image.frames.size();
+	PxlCrop(image);
+	report.empty = (PxlBoundingBox(image, report.x, report.y, report.width, report.height) == false);
+	report.x = image.x;
+	report.y = image.y;
+	report.width = image.width;
+	report.height = image.height;
+
+	bool found = false;
+	for(uint8_t encoding = Pxl::ENCODING_RGBA; encoding <= Pxl::ENCODING_PAL8; ++encoding)
+	{
+		std::vector<uint8_t> file;
+		std::string ignored;
+		if(PxlSerialize(image, (Pxl::encoding_t)encoding, file, ignored) == false) continue;
+
+		PxlReport candidate = report;
+		candidate.encoding = encoding;
+		_Estimate(image, device, file, candidate);
+		if(candidate.ram - (candidate.cached ? candidate.size : 0) > device.layer_arena) continue;
+
+		if(found == false || candidate.sd_rate < report.sd_rate || (candidate.sd_rate == report.sd_rate && (candidate.ram < report.ram || (candidate.ram == report.ram && candidate.size < report.size))))
+		{
+			report = candidate;
+			out = file;
+			found = true;
+		}
+	}
+	if(found == false)
+	{
+		error = "no encoding fits the device";
+		return false;
+	}
+
+	return true;
+}
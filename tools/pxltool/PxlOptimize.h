@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "PxlImage.h"
+
+// Параметры прошивки, по которым оценивается изображение; по умолчанию как в MatrixLogic.h.
+struct PxlDevice
+{
+	uint8_t width = 128;			// CFG_Width.
+	uint8_t height = 16;			// CFG_Height.
+	uint16_t render_delay = 200;	// CFG_Delay, слой перерисовывается с этим интервалом.
+	uint16_t layer_arena = 2048;	// CFG_LayerArena: буфер кадра или палитра и кэш слоя в одной памяти.
+	uint16_t sprite_arena = 512;	// CFG_SpriteArena.
+};
+
+struct PxlReport
+{
+	uint8_t encoding = 0;			// Выбранная кодировка.
+	size_t size = 0;				// Размер файла.
+	uint32_t sd_rate = 0;			// Ожидаемое чтение с карты при показе, байт/с.
+	uint32_t ram = 0;				// Память слоя: буфер кадра или палитра и кэш, байт.
+	bool cached = false;			// Файл помещается в кэш повторяющихся анимаций.
+	uint16_t frames_in = 0;
+	uint16_t frames_out = 0;		// Кадров после объединения одинаковых.
+	bool empty = false;				// Все кадры полностью прозрачные.
+	uint8_t x = 0;					// Прямоугольник слоя на панели после обрезки.
+	uint8_t y = 0;
+	uint8_t width = 0;
+	uint8_t height = 0;
+};
+
+// Изображение подходит под панель.
+bool PxlCheck(const PxlImage &image, const PxlDevice &device, std::string &error);
+
+// Объединить подряд идущие одинаковые кадры в один с суммарной длительностью.
+void PxlMergeFrames(PxlImage &image);
+
+// Прямоугольник, вне которого все кадры прозрачные; false, если прозрачно всё.
+bool PxlBoundingBox(const PxlImage &image, uint8_t &x, uint8_t &y, uint8_t &width, uint8_t &height);
+
+// Обрезать кадры по этому прямоугольнику, сдвинув положение слоя на панели.
+void PxlCrop(PxlImage &image);
+
+/*
+	Проверка, объединение кадров и выбор кодировки, при которой прошивка меньше всего
+	читает с карты во время показа, с учётом памяти слоя. out - файл PXL2.
+*/
+bool PxlOptimize(PxlImage &image, const PxlDevice &device, std::vector<uint8_t> &out, PxlReport &report, std::string &error);
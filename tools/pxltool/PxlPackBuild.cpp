@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
+#include <filesystem>
+#include <map>
+#include <vector>
+#include "PxlPackBuild.h"
+#include "PxlImage.h"
+
+static bool _Exists(const std::string &path)
+{
+	std::error_code error;
+
+	return std::filesystem::exists(path, error);
+}
+
+// Имя файла записи idx; на карте FAT имена могут оказаться в верхнем регистре.
+static std::string _EntryPath(const std::string &dir, uint16_t idx)
+{
+	char name[16];
+	if(idx < Pxl::PACK_USER) snprintf(name, sizeof(name), "layer%u.pxl", idx - Pxl::PACK_LAYER);
+	else snprintf(name, sizeof(name), "user%03u.pxl", idx - Pxl::PACK_USER + 1);
+
+	std::string path = dir + "/" + name;
+	if(_Exists(path) == true) return path;
+
+	for(char *ptr = name; *ptr != '\0'; ++ptr)
+	{
+		if(*ptr >= 'a' && *ptr <= 'z') *ptr -= 'a' - 'A';
+	}
+	path = dir + "/" + name;
+
+	return (_Exists(path) == true) ? path : "";
+}
+
+bool PxlPackBuild(const std::string &dir, Pxl::encoding_t encoding, const std::string &output, PxlPackStats &stats, std::string &error)
+{
+	Pxl::pack_header_t header = {};
+	memcpy(header.magic, Pxl::PACK_MAGIC, sizeof(header.magic));
+	header.version = Pxl::PACK_VERSION;
+	header.entry_count = Pxl::PACK_ENTRIES;
+
+	std::vector<Pxl::pack_entry_t> entries(Pxl::PACK_ENTRIES);
+	memset(entries.data(), 0x00, entries.size() * sizeof(Pxl::pack_entry_t));
+	std::vector<uint8_t> data;
+	std::map<std::vector<uint8_t>, uint32_t> written;
+	uint32_t base = sizeof(header) + entries.size() * sizeof(Pxl::pack_entry_t);
+
+	stats = PxlPackStats();
+	for(uint16_t idx = 0; idx < Pxl::PACK_ENTRIES; ++idx)
+	{
+		std::string path = _EntryPath(dir, idx);
+		if(path.empty() == true) continue;
+
+		PxlImage image;
+		std::vector<uint8_t> file;
+		if(PxlLoad(path, image, error) == false || PxlSerialize(image, encoding, file, error) == false)
+		{
+			error = path + ": " + error;
+			return false;
+		}
+		++stats.images;
+
+		Pxl::pack_entry_t &entry = entries[idx];
+		auto found = written.find(file);
+		if(found != written.end())
+		{
+			entry.offset = found->second;
+		}
+		else
+		{
+			entry.offset = base + data.size();
+			written[file] = entry.offset;
+			data.insert(data.end(), file.begin(), file.end());
+			++stats.unique;
+		}
+		entry.size = file.size();
+		entry.encoding = encoding;
+		entry.width = image.width;
+		entry.height = image.height;
+	}
+	if(stats.images == 0)
+	{
+		error = "no images found";
+		return false;
+	}
+
+	std::ofstream out(output, std::ios::binary);
+	out.write((const char *)&header, sizeof(header));
+	out.write((const char *)entries.data(), entries.size() * sizeof(Pxl::pack_entry_t));
+	out.write((const char *)data.data(), data.size());
+	if(!out)
+	{
+		error = "can't write file";
+		return false;
+	}
+	stats.size = base + data.size();
+
+	return true;
+}
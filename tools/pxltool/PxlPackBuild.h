@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <PxlFormat.h>
+
+struct PxlPackStats
+{
+	uint16_t images = 0;		// Найдено изображений.
+	uint16_t unique = 0;		// Из них записано, остальные совпали с уже записанными.
+	size_t size = 0;			// Размер пакета.
+};
+
+/*
+	Пакет из файлов layer0.pxl .. layer7.pxl и user001.pxl .. user255.pxl в папке dir.
+	Каждое изображение перекодируется в PXL2 в кодировке encoding, одинаковые результаты
+	записываются один раз.
+*/
+bool PxlPackBuild(const std::string &dir, Pxl::encoding_t encoding, const std::string &output, PxlPackStats &stats, std::string &error);
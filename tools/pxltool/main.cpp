@@ -0,0 +1,329 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+#include "PxlImage.h"
+#include "PxlPackBuild.h"
+#include "PxlAtlasBuild.h"
+#include "PxlOptimize.h"
+
+static void _Usage()
+{
+	printf(
+		"Usage:\n"
+		"  pxltool convert <encoding> <input> <output> [options]   convert PXL/PXL2 file to PXL2\n"
+		"  pxltool pack <encoding> <dir> <output>                  pack layerN.pxl and userNNN.pxl from dir\n"
+		"  pxltool optimize <dir> <output dir> [options]          check and convert all .pxl files for the device\n"
+		"  pxltool atlas <spec> <output> [--arena <bytes>]         build a sprite atlas, see PxlAtlasBuild.h\n"
+		"\n"
+		"Encodings: rgba, rle, delta, pal4, pal8\n"
+		"Options:\n"
+		"  --mode loop|once|pingpong   playback mode\n"
+		"  --loop <start> <end>        frames repeated after the intro\n"
+		"  --durations <ms,ms,...>     per-frame durations, 0 - header delay\n"
+		"  --crop                      crop to the opaque bounding box, keep the position on the panel\n"
+		"  --tween, --no-tween         blend neighbouring frames on the device, rgba and pal only\n"
+		"Optimize options:\n"
+		"  --panel <width>x<height>    panel size, default 128x16\n"
+		"  --jobs <n>                  worker threads, default - CPU count\n"
+		"Atlas options:\n"
+		"  --arena <bytes>             sprite memory of the device (CFG_SpriteArena), default 512\n"
+	);
+
+	return;
+}
+
+static long _FileSize(const std::string &path)
+{
+	std::error_code error;
+	uintmax_t size = std::filesystem::file_size(path, error);
+
+	return (error) ? -1 : (long)size;
+}
+
+// Параметры проигрывания из командной строки поверх прочитанных из файла.
+static bool _ParseOptions(int argc, char *argv[], PxlImage &image)
+{
+	static const char *modes[] = {"loop", "once", "pingpong"};
+
+	for(int i = 0; i < argc; ++i)
+	{
+		std::string option = argv[i];
+		if(option == "--mode" && i + 1 < argc)
+		{
+			std::string name = argv[++i];
+			uint8_t mode = 0;
+			while(mode < sizeof(modes) / sizeof(modes[0]) && name != modes[mode]) ++mode;
+			if(mode >= sizeof(modes) / sizeof(modes[0])) return false;
+
+			image.mode = mode;
+		}
+		else if(option == "--loop" && i + 2 < argc)
+		{
+			image.loop_start = atoi(argv[++i]);
+			image.loop_end = atoi(argv[++i]);
+		}
+		else if(option == "--durations" && i + 1 < argc)
+		{
+			image.durations.clear();
+			for(const char *ptr = argv[++i]; *ptr != '\0'; )
+			{
+				char *end;
+				image.durations.push_back(strtoul(ptr, &end, 10));
+				if(end == ptr) return false;
+
+				ptr = (*end == ',') ? end + 1 : end;
+			}
+			if(image.durations.size() != image.frames.size()) return false;
+		}
+		else if(option == "--crop")
+		{
+			PxlCrop(image);
+		}
+		else if(option == "--tween")
+		{
+			image.flags |= Pxl::LAYER_FLAG_TWEEN;
+		}
+		else if(option == "--no-tween")
+		{
+			image.flags &= ~Pxl::LAYER_FLAG_TWEEN;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static int _Convert(const std::string &encoding_name, const std::string &input, const std::string &output, int argc, char *argv[])
+{
+	Pxl::encoding_t encoding;
+	if(PxlEncodingParse(encoding_name, encoding) == false)
+	{
+		fprintf(stderr, "Unknown encoding: %s\n", encoding_name.c_str());
+		return 1;
+	}
+
+	PxlImage image;
+	std::string error;
+	if(PxlLoad(input, image, error) == false)
+	{
+		fprintf(stderr, "%s: %s\n", input.c_str(), error.c_str());
+		return 1;
+	}
+	if(_ParseOptions(argc, argv, image) == false)
+	{
+		fprintf(stderr, "Invalid options\n");
+		return 1;
+	}
+	if(PxlSave(output, image, encoding, error) == false)
+	{
+		fprintf(stderr, "%s: %s\n", input.c_str(), error.c_str());
+		return 1;
+	}
+
+	printf("%s: %ux%u at %u,%u, %zu frames, %ld -> %ld bytes (%s)\n", input.c_str(), image.width, image.height, image.x, image.y, image.frames.size(), _FileSize(input), _FileSize(output), encoding_name.c_str());
+
+	return 0;
+}
+
+static int _Pack(const std::string &encoding_name, const std::string &dir, const std::string &output)
+{
+	Pxl::encoding_t encoding;
+	if(PxlEncodingParse(encoding_name, encoding) == false)
+	{
+		fprintf(stderr, "Unknown encoding: %s\n", encoding_name.c_str());
+		return 1;
+	}
+
+	PxlPackStats stats;
+	std::string error;
+	if(PxlPackBuild(dir, encoding, output, stats, error) == false)
+	{
+		fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+
+	printf("%s: %u images, %u unique, %zu bytes (%s)\n", output.c_str(), stats.images, stats.unique, stats.size, encoding_name.c_str());
+
+	return 0;
+}
+
+static int _Atlas(const std::string &spec, const std::string &output, int argc, char *argv[])
+{
+	PxlDevice device;
+	for(int i = 0; i < argc; ++i)
+	{
+		std::string option = argv[i];
+		if(option == "--arena" && i + 1 < argc && atoi(argv[i + 1]) > 0 && atoi(argv[i + 1]) <= 65535)
+		{
+			device.sprite_arena = atoi(argv[++i]);
+		}
+		else
+		{
+			fprintf(stderr, "Invalid options\n");
+			return 1;
+		}
+	}
+
+	PxlAtlasStats stats;
+	std::string error;
+	if(PxlAtlasBuild(spec, device, output, stats, error) == false)
+	{
+		fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+
+	printf("%s: %u sprites, %u scripts, %zu bytes, largest sprite %u of %u bytes\n", output.c_str(), stats.sprites, stats.scripts, stats.size, stats.largest, device.sprite_arena);
+
+	return 0;
+}
+
+struct optimize_job_t
+{
+	std::string name;
+	PxlReport report;
+	std::string error;
+	bool result = false;
+};
+
+static bool _IsPxlName(const std::string &name)
+{
+	if(name.size() < 4) return false;
+
+	std::string ext = name.substr(name.size() - 4);
+	std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+	return (ext == ".pxl");
+}
+
+static void _OptimizeFile(const std::string &dir, const std::string &output_dir, const PxlDevice &device, optimize_job_t &job)
+{
+	PxlImage image;
+	std::vector<uint8_t> data;
+	if(PxlLoad(dir + "/" + job.name, image, job.error) == false || PxlOptimize(image, device, data, job.report, job.error) == false) return;
+
+	std::ofstream file(output_dir + "/" + job.name, std::ios::binary);
+	file.write((const char *)data.data(), data.size());
+	if(!file)
+	{
+		job.error = "can't write file";
+		return;
+	}
+	job.result = true;
+
+	return;
+}
+
+// Файлы обрабатываются пулом потоков, отчёт выводится по порядку имён.
+static int _Optimize(const std::string &dir, const std::string &output_dir, int argc, char *argv[])
+{
+	PxlDevice device;
+	unsigned jobs = std::thread::hardware_concurrency();
+	for(int i = 0; i < argc; ++i)
+	{
+		std::string option = argv[i];
+		unsigned width, height;
+		if(option == "--panel" && i + 1 < argc && sscanf(argv[i + 1], "%ux%u", &width, &height) == 2 && width > 0 && width <= 255 && height > 0 && height <= 255)
+		{
+			device.width = width;
+			device.height = height;
+			++i;
+		}
+		else if(option == "--jobs" && i + 1 < argc && atoi(argv[i + 1]) > 0)
+		{
+			jobs = atoi(argv[++i]);
+		}
+		else
+		{
+			fprintf(stderr, "Invalid options\n");
+			return 1;
+		}
+	}
+	if(jobs == 0) jobs = 1;
+
+	std::vector<optimize_job_t> list;
+	std::error_code error;
+	std::filesystem::directory_iterator items(dir, error);
+	if(error)
+	{
+		fprintf(stderr, "%s: can't open directory\n", dir.c_str());
+		return 1;
+	}
+	for(const auto &item : items)
+	{
+		std::string name = item.path().filename().string();
+		if(_IsPxlName(name) == false) continue;
+
+		optimize_job_t job;
+		job.name = name;
+		list.push_back(job);
+	}
+	std::sort(list.begin(), list.end(), [](const optimize_job_t &a, const optimize_job_t &b) { return a.name < b.name; });
+
+	std::atomic<size_t> next(0);
+	std::vector<std::thread> workers;
+	for(unsigned i = 0; i < jobs && i < list.size(); ++i)
+	{
+		workers.emplace_back([&]()
+		{
+			for(size_t idx = next++; idx < list.size(); idx = next++)
+			{
+				_OptimizeFile(dir, output_dir, device, list[idx]);
+			}
+		});
+	}
+	for(auto &worker : workers) worker.join();
+
+	int failed = 0;
+	for(const optimize_job_t &job : list)
+	{
+		if(job.result == false)
+		{
+			fprintf(stderr, "%s: %s\n", job.name.c_str(), job.error.c_str());
+			++failed;
+			continue;
+		}
+
+		const PxlReport &report = job.report;
+		printf("%s: %s, %zu bytes, frames %u -> %u, SD %u B/s, RAM %u B%s", job.name.c_str(), PxlEncodingName(report.encoding), report.size, report.frames_in, report.frames_out, report.sd_rate, report.ram, report.cached ? " (cached)" : "");
+		if(report.empty == true) printf(", empty\n");
+		else printf(", %ux%u at %u,%u\n", report.width, report.height, report.x, report.y);
+	}
+	printf("%zu files, %d failed\n", list.size(), failed);
+
+	return (failed > 0) ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+	std::string command = (argc > 1) ? argv[1] : "";
+
+	if(command == "convert" && argc >= 5)
+	{
+		return _Convert(argv[2], argv[3], argv[4], argc - 5, &argv[5]);
+	}
+	if(command == "pack" && argc == 5)
+	{
+		return _Pack(argv[2], argv[3], argv[4]);
+	}
+	if(command == "optimize" && argc >= 4)
+	{
+		return _Optimize(argv[2], argv[3], argc - 4, &argv[4]);
+	}
+	if(command == "atlas" && argc >= 4)
+	{
+		return _Atlas(argv[2], argv[3], argc - 4, &argv[4]);
+	}
+
+	_Usage();
+
+	return 1;
+}
@@ -0,0 +1,59 @@
+# Проверка RAM после сборки: PlatformIO extra_script (post:).
+# По секциям собранного ELF (arm-none-eabi-size -A) считает статическую память в RAM (.data, .bss и
+# прочие секции по адресам RAM, кроме резерва ._user_heap_stack из скрипта компоновщика) и остаток
+# под стек. Если остаток меньше custom_stack_reserve байт (по умолчанию 2048), сборка останавливается.
+# Фактические цифры для src/statistics.txt - строка "RAM check" в выводе pio run.
+# Без PlatformIO: python3 tools/ram_check.py <firmware.elf> [программа size] [RAM, байт] [резерв стека, байт]
+
+import subprocess
+import sys
+
+RAM_BASE = 0x20000000
+
+
+def _sections(size_tool, elf):
+	try:
+		output = subprocess.run([size_tool, "-A", elf], stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+	except OSError as error:
+		raise SystemExit("ram_check: %s: %s" % (size_tool, error))
+	if output.returncode != 0:
+		raise SystemExit("ram_check: %s failed:\n%s" % (size_tool, output.stdout))
+
+	sections = []
+	for line in output.stdout.splitlines():
+		fields = line.split()
+		if len(fields) == 3 and fields[1].isdigit() and fields[2].isdigit():
+			sections.append((fields[0], int(fields[1]), int(fields[2])))
+	return sections
+
+
+def check(size_tool, elf, ram, reserve):
+	used = 0
+	for name, size, addr in _sections(size_tool, elf):
+		if RAM_BASE <= addr < RAM_BASE + ram and not name.startswith("._user_heap_stack"):
+			used += size
+	headroom = ram - used
+
+	print("RAM check: static %d of %d bytes, stack headroom %d bytes (reserve %d)" % (used, ram, headroom, reserve))
+	if headroom < reserve:
+		print("ram_check: stack headroom %d bytes is less than custom_stack_reserve %d bytes" % (headroom, reserve))
+		return 1
+	return 0
+
+
+if __name__ == "__main__":
+	if len(sys.argv) < 2:
+		raise SystemExit("usage: ram_check.py <firmware.elf> [size tool] [ram] [reserve]")
+	size_tool = sys.argv[2] if len(sys.argv) > 2 else "arm-none-eabi-size"
+	ram = int(sys.argv[3]) if len(sys.argv) > 3 else 20480
+	reserve = int(sys.argv[4]) if len(sys.argv) > 4 else 2048
+	sys.exit(check(size_tool, sys.argv[1], ram, reserve))
+else:
+	Import("env")	# noqa: F821
+
+	def _post_link(target, source, env):
+		ram = int(env.BoardConfig().get("upload.maximum_ram_size", 20480))
+		reserve = int(env.GetProjectOption("custom_stack_reserve", "2048"))
+		return check(env.subst("$SIZETOOL"), str(target[0]), ram, reserve)
+
+	env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", _post_link)	# noqa: F821
@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "SdEmu.h"
+#include "SdCheck.h"
+#include "ff.h"
+#include "diskio.h"
+
+/*
+	Проверка чтения src/user_diskio.c и src/sd.c на модели карты: данные каждого чтения
+	сверяются с образом, а по счётчикам команд - что блоки подряд идут одним потоком CMD18,
+	продолжение по порядку не открывает новый поток, а запрос не по порядку, простой
+	и чтение за концом карты закрывают его командой CMD12.
+*/
+static constexpr uint32_t _Sectors = 2048;
+
+static uint8_t _Pattern(uint32_t sector, uint32_t offset)
+{
+	return (uint8_t)(sector * 7 + offset + (sector >> 8));
+}
+
+class SdChecker
+{
+	public:
+
+		// Чтение и команды, которые оно должно послать карте.
+		void Read(const char *name, DWORD sector, UINT count, uint32_t cmd18, uint32_t cmd12, bool async = false)
+		{
+			SdEmuStats before = SdEmuGetStats();
+			std::vector<uint8_t> buffer(count * 512, 0x00);
+			DRESULT result;
+
+			if(async == true)
+			{
+				DISK_READ_ASYNC read = {};
+				read.buff = buffer.data();
+				read.sector = sector;
+				read.count = count;
+				result = disk_ioctl(0, CTRL_READ_START, &read);
+				while(result == RES_OK && read.busy == 1)
+				{
+					disk_ioctl(0, CTRL_READ_POLL, nullptr);
+					SdEmuAdvance(10000);
+				}
+				if(result == RES_OK) result = read.res;
+			}
+			else
+			{
+				result = disk_read(0, buffer.data(), sector, count);
+			}
+
+			bool data = true;
+			for(uint32_t i = 0; i < count * 512; ++i)
+			{
+				if(buffer[i] != _Pattern(sector + i / 512, i % 512)) data = false;
+			}
+			_Result(name, result == RES_OK && data == true, SdEmuGetStats(), before, cmd18, cmd12);
+
+			return;
+		}
+
+		// Чтение, которое должно завершиться ошибкой.
+		void ReadError(const char *name, DWORD sector, UINT count, uint32_t cmd18, uint32_t cmd12)
+		{
+			SdEmuStats before = SdEmuGetStats();
+			std::vector<uint8_t> buffer(count * 512);
+
+			DRESULT result = disk_read(0, buffer.data(), sector, count);
+			_Result(name, result != RES_OK, SdEmuGetStats(), before, cmd18, cmd12);
+
+			return;
+		}
+
+		// Простой без запросов: поток должен закрыться.
+		void Idle(const char *name, uint32_t ms, uint32_t cmd12)
+		{
+			SdEmuStats before = SdEmuGetStats();
+
+			for(uint32_t i = 0; i < ms; ++i)
+			{
+				disk_ioctl(0, CTRL_READ_POLL, nullptr);
+				SdEmuAdvance(1000000);
+			}
+			_Result(name, true, SdEmuGetStats(), before, 0, cmd12);
+
+			return;
+		}
+
+		// Профиль карты: есть только после успешных замеров.
+		void Profile(const char *name, DRESULT expected)
+		{
+			SdEmuStats before = SdEmuGetStats();
+			DISK_BENCHMARK bench = {};
+
+			DRESULT result = disk_ioctl(0, CTRL_PROFILE, &bench);
+			_Result(name, result == expected, SdEmuGetStats(), before, 0, 0);
+
+			return;
+		}
+
+		uint32_t Failed() const
+		{
+			return _failed;
+		}
+
+	private:
+
+		void _Result(const char *name, bool ok, const SdEmuStats &after, const SdEmuStats &before, uint32_t cmd18, uint32_t cmd12)
+		{
+			uint32_t sent18 = after.cmd18 - before.cmd18;
+			uint32_t sent12 = after.cmd12 - before.cmd12;
+
+			ok = ok && sent18 == cmd18 && sent12 == cmd12;
+			if(ok == false) _failed++;
+			printf("%-4s %-40s CMD18 %u (%u), CMD12 %u (%u), CMD17 %u\n", (ok ? "ok" : "FAIL"), name, sent18, cmd18, sent12, cmd12, after.cmd17 - before.cmd17);
+
+			return;
+		}
+
+		uint32_t _failed = 0;
+};
+
+int SdCheck(const SdEmuConfig &config)
+{
+	std::vector<uint8_t> image(_Sectors * 512);
+	for(uint32_t i = 0; i < image.size(); ++i) image[i] = _Pattern(i / 512, i % 512);
+
+	SdEmuConfig card = config;
+	card.card = true;
+	std::string error;
+	if(SdEmuStart(std::move(image), card, error) == false)
+	{
+		fprintf(stderr, "check: %s\n", error.c_str());
+		return 1;
+	}
+	if(disk_initialize(0) != 0)
+	{
+		fprintf(stderr, "check: card initialization error\n");
+		return 1;
+	}
+	printf("Card: %s, %u sectors\n", (config.sdsc ? "SDSC, byte addressing" : "SDHC, block addressing"), _Sectors);
+
+	SdChecker check;
+	check.Profile("no benchmark: no profile", RES_NOTRDY);
+	check.Read("8 blocks: new CMD18 stream", 100, 8, 1, 0);
+	check.Read("4 blocks in order: same stream", 108, 4, 0, 0);
+	check.Read("1 block in order: same stream", 112, 1, 0, 0);
+	check.Read("3 blocks out of order: CMD12, CMD18", 500, 3, 1, 1);
+	check.Read("1 block out of order: CMD12, CMD18", 7, 1, 1, 1);
+	check.Read("16 blocks async in order", 8, 16, 0, 0, true);
+	check.Idle("idle 25 ms: CMD12", 25, 1);
+	check.Read("4 blocks async: new stream", 1000, 4, 1, 0, true);
+	check.Read("last 4 blocks of the card", _Sectors - 4, 4, 1, 1);
+	check.Read("read-ahead error: new stream", _Sectors - 2, 2, 1, 1);
+	check.ReadError("past the end of the card: error", 100, 2000, 1, 2);
+	check.Read("after error: new stream", 0, 2, 1, 0);
+
+	if(check.Failed() > 0)
+	{
+		printf("%u checks failed\n", check.Failed());
+		return 1;
+	}
+	printf("All checks passed\n");
+
+	return 0;
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+#include "SdEmu.h"
+
+// Проверка потокового чтения CMD18/CMD12 драйверов прошивки на модели карты, 0 - успех.
+int SdCheck(const SdEmuConfig &config);
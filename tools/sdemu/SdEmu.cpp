@@ -0,0 +1,476 @@
+#include <stdio.h>
+#include <string.h>
+#include <deque>
+#include <vector>
+#include "SdEmu.h"
+#include "stm32f1xx_hal.h"
+#include "ff_gen_drv.h"
+#include "user_diskio.h"
+
+static constexpr uint16_t _BlockSize = 512;
+
+static SdEmuConfig _config;
+static SdEmuStats _stats;
+static std::vector<uint8_t> _image;
+static uint64_t _time = 0;
+
+// Периферия, к которой обращаются src/sd.c и src/user_diskio.c.
+static GPIO_TypeDef _gpioa;
+static DWT_Type _dwt;
+static CoreDebug_Type _core_debug;
+extern "C"
+{
+	GPIO_TypeDef *GPIOA = &_gpioa;
+	DWT_Type *DWT = &_dwt;
+	CoreDebug_Type *CoreDebug = &_core_debug;
+	uint32_t SystemCoreClock = 64000000;
+	SPI_HandleTypeDef hspi2;
+}
+
+static void _SetTime(uint64_t time)
+{
+	_time = time;
+	_dwt.CYCCNT = (uint32_t)(_time * (SystemCoreClock / 1000000U) / 1000U);
+
+	return;
+}
+
+// Байт по SPI на текущем делителе, нс.
+static uint64_t _ByteTime()
+{
+	uint32_t divider = 2U << (hspi2.Init.BaudRatePrescaler / SPI_BAUDRATEPRESCALER_4);
+
+	return 8000000000ULL * divider / _config.spi_clock;
+}
+
+/*
+	Карта в режиме SPI. Команда - 6 байт, начиная с байта 01xxxxxx; ответ - через байт 0xFF.
+	Блок данных (токен 0xFE, 512 байт, CRC) готов через latency после CMD17/CMD18, в потоке CMD18
+	следующий - через gap после предыдущего. Пока блок не готов, карта отдаёт 0xFF.
+*/
+class SdCard
+{
+	public:
+
+		uint8_t Transfer(uint8_t mosi)
+		{
+			if(_length > 0 || (mosi & 0xC0) == 0x40)
+			{
+				_command[_length++] = mosi;
+				if(_length == sizeof(_command))
+				{
+					_length = 0;
+					_Execute();
+				}
+				return 0xFF;
+			}
+			if(_out.empty() == false)
+			{
+				uint8_t result = _out.front();
+				_out.pop_front();
+				return result;
+			}
+			if(_stream == true && _pending == false)
+			{
+				_pending = true;
+				_ready = _time + _config.gap * 1000ULL;
+			}
+			if(_pending == false || _time < _ready) return 0xFF;
+
+			_pending = false;
+			_Block();
+
+			return 0xFF;
+		}
+
+	private:
+
+		void _Execute()
+		{
+			uint8_t cmd = _command[0] & 0x3F;
+			uint32_t arg = (uint32_t)_command[1] << 24 | (uint32_t)_command[2] << 16 | (uint32_t)_command[3] << 8 | _command[4];
+			bool app = _app;
+
+			_stats.commands++;
+			_app = false;
+			_out.clear();
+
+			// После CMD12 - байт данных (stuff byte), R1 и занятость.
+			if(cmd == 12)
+			{
+				_stats.cmd12++;
+				_stream = false;
+				_pending = false;
+				_out.insert(_out.end(), {0xFF, 0x00, 0x00, 0x00});
+				return;
+			}
+
+			_out.push_back(0xFF);
+			switch(cmd)
+			{
+				case 0:
+				{
+					_idle = true;
+					_stream = false;
+					_pending = false;
+					_out.push_back(0x01);
+					break;
+				}
+				case 8:
+				{
+					_out.insert(_out.end(), {0x01, 0x00, 0x00, (uint8_t)(arg >> 8), (uint8_t)arg});
+					break;
+				}
+				case 55:
+				{
+					_app = true;
+					_out.push_back(_idle ? 0x01 : 0x00);
+					break;
+				}
+				case 41:
+				{
+					if(app == false)
+					{
+						_out.push_back(0x04);
+						break;
+					}
+					if(_time >= _config.init * 1000000ULL) _idle = false;
+					_out.push_back(_idle ? 0x01 : 0x00);
+					break;
+				}
+				case 58:
+				{
+					uint8_t ocr = (_idle ? 0x00 : 0x80) | (_config.sdsc ? 0x00 : 0x40);
+					_out.insert(_out.end(), {(uint8_t)(_idle ? 0x01 : 0x00), ocr, 0xFF, 0x80, 0x00});
+					break;
+				}
+				case 16:
+				{
+					_out.push_back((arg == _BlockSize) ? 0x00 : 0x40);
+					break;
+				}
+				case 17:
+				case 18:
+				{
+					uint32_t sector = (_config.sdsc == true) ? arg / _BlockSize : arg;
+					if(_idle == true || sector >= _image.size() / _BlockSize)
+					{
+						_out.push_back((_idle == true) ? 0x01 : 0x20);
+						break;
+					}
+					if(cmd == 17) _stats.cmd17++;
+					else _stats.cmd18++;
+					_out.push_back(0x00);
+					_sector = sector;
+					_stream = (cmd == 18);
+					_pending = true;
+					_ready = _time + _config.latency * 1000ULL;
+					break;
+				}
+				default:
+				{
+					_out.push_back(0x04);
+					break;
+				}
+			}
+
+			return;
+		}
+
+		void _Block()
+		{
+			if(_sector >= _image.size() / _BlockSize)
+			{
+				_stream = false;
+				_out.push_back(0x08);		// Data error token: за концом образа.
+				return;
+			}
+
+			const uint8_t *data = &_image[(size_t)_sector * _BlockSize];
+			_out.push_back(0xFE);
+			_out.insert(_out.end(), data, data + _BlockSize);
+			_out.insert(_out.end(), {0xFF, 0xFF});
+			_stats.blocks++;
+			_sector++;
+
+			return;
+		}
+
+		uint8_t _command[6];
+		uint8_t _length = 0;
+		std::deque<uint8_t> _out;
+		bool _idle = true;
+		bool _app = false;
+		bool _stream = false;
+		bool _pending = false;			// Ждём готовности блока _sector.
+		uint64_t _ready = 0;
+		uint32_t _sector = 0;
+};
+
+static SdCard _card;
+
+// Приём по DMA: байты передаются сразу, но процессор свободен до _dma_end.
+static uint64_t _dma_end = 0;
+static constexpr uint64_t _PollTime = 1000;
+
+static uint8_t _Transfer(uint8_t mosi)
+{
+	uint64_t byte_time = _ByteTime();
+
+	_SetTime(_time + byte_time);
+	_stats.blocked += byte_time;
+	_stats.spi_bytes++;
+
+	return _card.Transfer(mosi);
+}
+
+extern "C"
+{
+	uint32_t HAL_GetTick(void)
+	{
+		return (uint32_t)(_time / 1000000U);
+	}
+
+	HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef *)
+	{
+		return HAL_OK;
+	}
+
+	void HAL_GPIO_WritePin(GPIO_TypeDef *, uint16_t, GPIO_PinState)
+	{
+		return;
+	}
+
+	void HAL_SPI_ReadFast(uint8_t *pRxData, uint16_t Size, uint32_t)
+	{
+		while(Size--) *pRxData++ = _Transfer(0xFF);
+
+		return;
+	}
+
+	void HAL_SPI_WriteFast(uint8_t *pTxData, uint16_t Size, uint32_t)
+	{
+		while(Size--) _Transfer(*pTxData++);
+
+		return;
+	}
+
+	void HAL_SPI_WriteReadFast(uint8_t *pTxData, uint8_t *pRxData, uint16_t Size, uint32_t)
+	{
+		while(Size--) *pRxData++ = _Transfer(*pTxData++);
+
+		return;
+	}
+
+	void HAL_SPI_ReadDMA(uint8_t *pRxData, uint16_t Size)
+	{
+		uint64_t start = _time;
+		uint64_t blocked = _stats.blocked;
+
+		HAL_SPI_ReadFast(pRxData, Size, 0);
+		_dma_end = _time;
+		_stats.blocked = blocked;
+		_SetTime(start);
+
+		return;
+	}
+
+	// Каждый опрос занимает процессор, иначе ожидание в цикле не двигало бы время.
+	uint8_t HAL_SPI_ReadDMA_IsBusy(void)
+	{
+		_SetTime(_time + _PollTime);
+
+		return (_time < _dma_end) ? 1 : 0;
+	}
+
+	uint8_t HAL_SPI_ReadDMA_Wait(uint32_t)
+	{
+		if(_time < _dma_end)
+		{
+			_stats.blocked += _dma_end - _time;
+			_SetTime(_dma_end);
+		}
+
+		return 0;
+	}
+}
+
+/*
+	Драйвер без модели карты: каждое чтение - задержка latency и передача блоков по SPI
+	с делителем 2, между блоками - gap. Асинхронное чтение (CTRL_READ_START) завершается,
+	когда виртуальное время дойдёт до его окончания.
+*/
+static DISK_READ_ASYNC *_async = nullptr;
+static uint64_t _async_end = 0;
+
+static uint64_t _ReadTime(UINT count)
+{
+	return _config.latency * 1000ULL + (_config.gap * 1000ULL + _ByteTime() * (_BlockSize + 3)) * count - _config.gap * 1000ULL;
+}
+
+static DRESULT _Copy(BYTE *buff, DWORD sector, UINT count)
+{
+	if(sector >= _image.size() / _BlockSize || count > _image.size() / _BlockSize - sector) return RES_PARERR;
+
+	memcpy(buff, &_image[(size_t)sector * _BlockSize], (size_t)count * _BlockSize);
+	_stats.reads++;
+	_stats.blocks += count;
+
+	return RES_OK;
+}
+
+static void _AsyncWait()
+{
+	if(_async == nullptr) return;
+
+	if(_time < _async_end)
+	{
+		_stats.blocked += _async_end - _time;
+		_SetTime(_async_end);
+	}
+	_async->busy = 0;
+	_async = nullptr;
+
+	return;
+}
+
+static DSTATUS _ImageInitialize(BYTE pdrv)
+{
+	if(_time < _config.init * 1000000ULL) _SetTime(_config.init * 1000000ULL);
+
+	return (pdrv == 0) ? 0 : STA_NOINIT;
+}
+
+static DSTATUS _ImageStatus(BYTE pdrv)
+{
+	return (pdrv == 0) ? 0 : STA_NOINIT;
+}
+
+static DRESULT _ImageRead(BYTE, BYTE *buff, DWORD sector, UINT count)
+{
+	_AsyncWait();
+
+	uint64_t time = _ReadTime(count);
+	_stats.blocked += time;
+	_SetTime(_time + time);
+
+	return _Copy(buff, sector, count);
+}
+
+static DRESULT _ImageIoctl(BYTE, BYTE cmd, void *buff)
+{
+	if(cmd == CTRL_READ_START)
+	{
+		DISK_READ_ASYNC *read = (DISK_READ_ASYNC *)buff;
+		_AsyncWait();
+		read->res = _Copy(read->buff, read->sector, read->count);
+		if(read->res != RES_OK) return RES_ERROR;
+		read->busy = 1;
+		_async = read;
+		_async_end = _time + _ReadTime(read->count);
+		return RES_OK;
+	}
+	if(cmd == CTRL_READ_POLL)
+	{
+		if(_async != nullptr && _time >= _async_end) _AsyncWait();
+		return RES_OK;
+	}
+
+	_AsyncWait();
+	switch(cmd)
+	{
+		case CTRL_SYNC:
+		{
+			return RES_OK;
+		}
+		case GET_SECTOR_COUNT:
+		{
+			*(DWORD *)buff = _image.size() / _BlockSize;
+			return RES_OK;
+		}
+		case GET_SECTOR_SIZE:
+		{
+			*(WORD *)buff = _BlockSize;
+			return RES_OK;
+		}
+		default:
+		{
+			return RES_PARERR;
+		}
+	}
+}
+
+static Diskio_drvTypeDef _ImageDriver =
+{
+	_ImageInitialize,
+	_ImageStatus,
+	_ImageRead,
+#if _USE_WRITE == 1
+	nullptr,
+#endif
+#if _USE_IOCTL == 1
+	_ImageIoctl,
+#endif
+};
+
+bool SdEmuStart(const std::string &filename, const SdEmuConfig &config, std::string &error)
+{
+	FILE *file = fopen(filename.c_str(), "rb");
+	if(file == nullptr)
+	{
+		error = "can't open image";
+		return false;
+	}
+	std::vector<uint8_t> image;
+	uint8_t buffer[4096];
+	for(size_t length; (length = fread(buffer, 1, sizeof(buffer), file)) > 0; )
+	{
+		image.insert(image.end(), buffer, buffer + length);
+	}
+	fclose(file);
+
+	return SdEmuStart(std::move(image), config, error);
+}
+
+bool SdEmuStart(std::vector<uint8_t> image, const SdEmuConfig &config, std::string &error)
+{
+	static char path[4];
+
+	_image = std::move(image);
+	if(_image.size() < _BlockSize)
+	{
+		error = "image is too small";
+		return false;
+	}
+	_image.resize(_image.size() - _image.size() % _BlockSize);
+
+	_config = config;
+	_stats = SdEmuStats();
+	_SetTime(0);
+	hspi2.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_2;
+
+	if(FATFS_LinkDriver((config.card == true) ? &USER_Driver : &_ImageDriver, path) != 0)
+	{
+		error = "can't link driver";
+		return false;
+	}
+
+	return true;
+}
+
+uint64_t SdEmuTime()
+{
+	return _time;
+}
+
+void SdEmuAdvance(uint64_t ns)
+{
+	_SetTime(_time + ns);
+
+	return;
+}
+
+const SdEmuStats &SdEmuGetStats()
+{
+	return _stats;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/*
+	SD-карта на ПК: сектора берутся из файла образа FAT. Время виртуальное - его двигают
+	обмен с картой и цикл программы (SdEmuAdvance()), HAL_GetTick() и DWT идут по нему.
+	Без модели карты drive 0 FatFs читает образ напрямую, с задержкой на каждое чтение.
+	С моделью (card) читают драйверы прошивки src/user_diskio.c и src/sd.c, а карта отвечает
+	побайтно по SPI на CMD0/8/12/16/17/18/55/58 и ACMD41.
+*/
+struct SdEmuConfig
+{
+	bool card = false;				// Модель карты по SPI.
+	bool sdsc = false;				// Модель SDSC (адрес в байтах), иначе SDHC.
+	uint32_t latency = 800;			// От команды чтения до токена данных, мкс.
+	uint32_t gap = 50;				// Между блоками потока CMD18, мкс.
+	uint32_t init = 50;				// Выход карты из ожидания (ACMD41) после включения, мс.
+	uint32_t spi_clock = 32000000;	// Частота SPI2 до делителя (APB1), Гц. Без модели - делитель 2.
+};
+
+struct SdEmuStats
+{
+	uint32_t commands = 0;			// Команд карте, с моделью.
+	uint32_t cmd17 = 0;
+	uint32_t cmd18 = 0;
+	uint32_t cmd12 = 0;
+	uint32_t reads = 0;				// Чтений образа, без модели.
+	uint32_t blocks = 0;			// Передано блоков.
+	uint64_t spi_bytes = 0;
+	uint64_t blocked = 0;			// Процессор ждал карту, нс.
+};
+
+// Загрузить образ и подключить драйвер к FatFs.
+bool SdEmuStart(const std::string &filename, const SdEmuConfig &config, std::string &error);
+bool SdEmuStart(std::vector<uint8_t> image, const SdEmuConfig &config, std::string &error);
+
+// Виртуальное время, нс.
+uint64_t SdEmuTime();
+
+// Работа программы помимо карты: время идёт, карта готовит данные.
+void SdEmuAdvance(uint64_t ns);
+
+const SdEmuStats &SdEmuGetStats();
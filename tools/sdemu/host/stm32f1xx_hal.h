@@ -0,0 +1,91 @@
+#pragma once
+
+/*
+	Часть HAL, которую используют src/sd.c, src/user_diskio.c и ffconf.h, для сборки на ПК.
+	Время - виртуальные часы эмулятора (SdEmu.cpp), SPI и DMA - модель карты.
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define __IO volatile
+#define __weak __attribute__((weak))
+
+typedef enum
+{
+	HAL_OK = 0,
+	HAL_ERROR,
+	HAL_BUSY,
+	HAL_TIMEOUT
+} HAL_StatusTypeDef;
+
+typedef enum
+{
+	GPIO_PIN_RESET = 0,
+	GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef struct
+{
+	uint32_t ODR;
+} GPIO_TypeDef;
+
+#define GPIO_PIN_8 ((uint16_t)0x0100)
+
+extern GPIO_TypeDef *GPIOA;
+
+#define SPI_BAUDRATEPRESCALER_2		0x00000000U
+#define SPI_BAUDRATEPRESCALER_4		0x00000008U
+#define SPI_BAUDRATEPRESCALER_8		0x00000010U
+#define SPI_BAUDRATEPRESCALER_16	0x00000018U
+#define SPI_BAUDRATEPRESCALER_32	0x00000020U
+#define SPI_BAUDRATEPRESCALER_64	0x00000028U
+#define SPI_BAUDRATEPRESCALER_128	0x00000030U
+#define SPI_BAUDRATEPRESCALER_256	0x00000038U
+
+typedef struct
+{
+	uint32_t BaudRatePrescaler;
+} SPI_InitTypeDef;
+
+typedef struct
+{
+	SPI_InitTypeDef Init;
+} SPI_HandleTypeDef;
+
+typedef struct
+{
+	uint32_t Instance;
+} TIM_HandleTypeDef;
+
+// Счётчик тактов ядра: идёт по виртуальным часам с частотой SystemCoreClock.
+typedef struct
+{
+	uint32_t CTRL;
+	uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+	uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define CoreDebug_DEMCR_TRCENA_Msk	(1UL << 24)
+#define DWT_CTRL_CYCCNTENA_Msk		(1UL << 0)
+
+extern DWT_Type *DWT;
+extern CoreDebug_Type *CoreDebug;
+extern uint32_t SystemCoreClock;
+
+uint32_t HAL_GetTick(void);
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef *hspi);
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+
+#ifdef __cplusplus
+}
+#endif
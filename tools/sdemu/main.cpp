@@ -0,0 +1,261 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include "SdEmu.h"
+#include "SdCheck.h"
+#include "ff.h"
+#include "diskio.h"
+#include <MatrixLayers.h>
+#include <MatrixCanvas.h>
+#include <PxlPack.h>
+
+// Параметры слоёв как в MatrixLogic.h.
+static constexpr uint8_t CFG_Layers = 8;
+static constexpr uint8_t CFG_Width = 128;
+static constexpr uint8_t CFG_Height = 16;
+static constexpr uint16_t CFG_LayerArena = 2048;
+static constexpr uint16_t CFG_LinkMap = 32;
+static constexpr uint16_t CFG_PackLinkMap = 16;
+
+static FATFS _fs;
+static PxlPack<CFG_PackLinkMap> _pack;
+static MatrixLayers<CFG_Layers, CFG_Width, CFG_Height, CFG_LayerArena, CFG_LinkMap> _layers;
+static MatrixCanvas<CFG_Width, CFG_Height> _canvas;
+static uint8_t _frame[CFG_Width * CFG_Height * 3];
+
+struct options_t
+{
+	SdEmuConfig config;
+	uint32_t loop = 200;			// Работа цикла программы помимо карты за итерацию, мкс.
+	uint32_t delay = 200;			// Интервал кадров (CFG_Delay), мс.
+	uint32_t time = 10000;			// Время проигрывания, мс.
+	std::vector<uint8_t> show;		// Показать слои, пусто - все зарегистрированные.
+};
+
+static void _Usage()
+{
+	printf(
+		"Usage:\n"
+		"  sdemu <image> [options]   mount a FAT image and play its pxl_r layers like the firmware\n"
+		"  sdemu --check [options]   check CMD18/CMD12 reads of the firmware drivers on the card model\n"
+		"\n"
+		"Options:\n"
+		"  --card                    read through src/sd.c and src/user_diskio.c and an SPI card model\n"
+		"  --sdsc                    card model: SDSC with byte addressing, default SDHC\n"
+		"  --latency <us>            command to data token, default 800\n"
+		"  --gap <us>                between blocks of a CMD18 stream, default 50\n"
+		"  --init <ms>               card initialization (ACMD41 busy), default 50\n"
+		"  --loop <us>               main loop work besides the card per iteration, default 200\n"
+		"  --delay <ms>              frame interval (CFG_Delay), default 200\n"
+		"  --time <ms>               playback time, default 10000\n"
+		"  --show <id,id,...>        layers to show, default all registered\n"
+	);
+
+	return;
+}
+
+static bool _ParseOptions(int argc, char *argv[], options_t &options)
+{
+	for(int i = 0; i < argc; ++i)
+	{
+		std::string option = argv[i];
+		bool value = (i + 1 < argc);
+		if(option == "--card")
+		{
+			options.config.card = true;
+		}
+		else if(option == "--sdsc")
+		{
+			options.config.sdsc = true;
+		}
+		else if(option == "--latency" && value)
+		{
+			options.config.latency = strtoul(argv[++i], nullptr, 10);
+		}
+		else if(option == "--gap" && value)
+		{
+			options.config.gap = strtoul(argv[++i], nullptr, 10);
+		}
+		else if(option == "--init" && value)
+		{
+			options.config.init = strtoul(argv[++i], nullptr, 10);
+		}
+		else if(option == "--loop" && value)
+		{
+			options.loop = strtoul(argv[++i], nullptr, 10);
+		}
+		else if(option == "--delay" && value && atoi(argv[i + 1]) > 0)
+		{
+			options.delay = strtoul(argv[++i], nullptr, 10);
+		}
+		else if(option == "--time" && value)
+		{
+			options.time = strtoul(argv[++i], nullptr, 10);
+		}
+		else if(option == "--show" && value)
+		{
+			for(const char *ptr = argv[++i]; *ptr != '\0'; )
+			{
+				char *end;
+				unsigned long id = strtoul(ptr, &end, 10);
+				if(end == ptr || id >= CFG_Layers) return false;
+				options.show.push_back(id);
+
+				ptr = (*end == ',') ? end + 1 : end;
+			}
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static double _Ms(uint64_t ns)
+{
+	return ns / 1000000.0;
+}
+
+// Слои из пакета, если он есть, иначе из отдельных файлов - как Matrix::Setup().
+static uint8_t _RegLayers()
+{
+	uint8_t count = 0;
+
+	f_chdir("/pxl_r");
+	_pack.Open("assets.pak");
+	for(uint8_t i = 0; i < CFG_Layers; ++i)
+	{
+		char filename[13];
+		Pxl::pack_entry_t entry;
+		bool result;
+
+		snprintf(filename, sizeof(filename), "layer%u.pxl", i);
+		if(_pack.GetEntry(Pxl::PACK_LAYER + i, entry) == true) result = _layers.RegLayer(_pack.File(), entry.offset, entry.size, i);
+		else result = _layers.RegLayer(filename, i);
+		if(result == true) ++count;
+	}
+
+	return count;
+}
+
+int main(int argc, char *argv[])
+{
+	options_t options;
+	if(argc < 2 || _ParseOptions(argc - 2, &argv[2], options) == false)
+	{
+		_Usage();
+		return 1;
+	}
+	if(strcmp(argv[1], "--check") == 0)
+	{
+		return SdCheck(options.config);
+	}
+
+	std::string error;
+	if(SdEmuStart(argv[1], options.config, error) == false)
+	{
+		fprintf(stderr, "%s: %s\n", argv[1], error.c_str());
+		return 1;
+	}
+
+	disk_initialize(0);
+	FRESULT mount_res = f_mount(&_fs, "", 1);
+	if(mount_res != FR_OK)
+	{
+		fprintf(stderr, "%s: mount error, code: %d\n", argv[1], mount_res);
+		return 1;
+	}
+	printf("Mount: %.1f ms\n", _Ms(SdEmuTime()));
+
+	// Как InitFlash() в прошивке: кэш секторов FAT и замеры карты.
+	if(options.config.card == true)
+	{
+		disk_ioctl(0, CTRL_CACHE_LIMIT, &_fs.database);
+
+		DISK_BENCHMARK bench = {};
+		bench.buff = _fs.win.d8;
+		bench.sector = _fs.database;
+		bench.count = 16;
+		if(disk_ioctl(0, CTRL_BENCHMARK, &bench) == RES_OK)
+		{
+			printf("Card: init %u ms, latency %u us, CMD17 %u KB/s, CMD18 %u KB/s, SPI /%u, read-ahead %s\n", bench.init_time, bench.latency, bench.single_rate, bench.multi_rate, bench.spi_divider, (bench.read_ahead ? "on" : "off"));
+		}
+		else
+		{
+			printf("Card: benchmark error\n");
+		}
+		_fs.winsect = 0xFFFFFFFF;
+	}
+
+	uint64_t reg_time = SdEmuTime();
+	uint8_t registered = _RegLayers();
+	reg_time = SdEmuTime() - reg_time;
+	printf("Layers: %u registered, %.1f ms, link map %u bytes, contiguous %u\n", registered, _Ms(reg_time), _layers.LinkMapUsed(), _layers.ContiguousLayers());
+
+	if(options.show.empty() == true)
+	{
+		for(uint8_t i = 0; i < CFG_Layers; ++i)
+		{
+			if(_layers.IsRegistered(i) == true) options.show.push_back(i);
+		}
+	}
+	for(uint8_t id : options.show) _layers.ShowLayer(id);
+
+	_canvas.Attach(_frame, sizeof(_frame));
+	_canvas.SetBrightness(255);
+
+	// Цикл программы: кадр по интервалу, между кадрами - упреждающее чтение и опрос карты.
+	uint64_t start = SdEmuTime();
+	uint64_t end = start + options.time * 1000000ULL;
+	uint64_t next_frame = start;
+	uint64_t render_sum = 0, render_max = 0;
+	uint64_t host_sum = 0;
+	uint64_t hash = 1469598103934665603ULL;
+	uint32_t frames = 0;
+	while(SdEmuTime() < end)
+	{
+		if(SdEmuTime() >= next_frame)
+		{
+			uint64_t render_start = SdEmuTime();
+			auto host_start = std::chrono::steady_clock::now();
+
+			memset(_frame, 0x00, sizeof(_frame));
+			_layers.Render(_canvas, HAL_GetTick());
+
+			host_sum += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - host_start).count();
+			uint64_t render = SdEmuTime() - render_start;
+			render_sum += render;
+			if(render > render_max) render_max = render;
+			for(uint8_t byte : _frame) hash = (hash ^ byte) * 1099511628211ULL;
+			frames++;
+			next_frame += options.delay * 1000000ULL;
+		}
+		else
+		{
+			_layers.Prefetch();
+		}
+		disk_ioctl(0, CTRL_READ_POLL, nullptr);
+		SdEmuAdvance(options.loop * 1000ULL);
+	}
+
+	const SdEmuStats &stats = SdEmuGetStats();
+	frames = (frames > 0) ? frames : 1;
+	printf("Render: %u frames, card wait %.2f ms avg, %.2f ms max, host %.1f us per frame\n", frames, _Ms(render_sum / frames), _Ms(render_max), host_sum / 1000.0 / frames);
+	printf("Prefetch: %u hits, %u misses; frame cache: %u hits, %u misses, %u bytes\n", _layers.PrefetchHits(), _layers.PrefetchMisses(), _layers.CacheHits(), _layers.CacheMisses(), _layers.CacheUsed());
+	if(options.config.card == true)
+	{
+		printf("SD: %u commands (CMD17 %u, CMD18 %u, CMD12 %u), %u blocks, %llu SPI bytes, CPU blocked %.1f ms\n", stats.commands, stats.cmd17, stats.cmd18, stats.cmd12, stats.blocks, (unsigned long long)stats.spi_bytes, _Ms(stats.blocked));
+	}
+	else
+	{
+		printf("SD: %u reads, %u blocks, CPU blocked %.1f ms\n", stats.reads, stats.blocks, _Ms(stats.blocked));
+	}
+	printf("Canvas hash: %016llx\n", (unsigned long long)hash);
+
+	return 0;
+}